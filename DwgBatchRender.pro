@@ -0,0 +1,10 @@
+# Rendu en lot DWG -> PNG en ligne de commande (plateforme Qt offscreen)
+TARGET = DwgBatchRender
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(DwgCommon.pri)
+
+SOURCES += \
+    batchmain.cpp
@@ -0,0 +1,10 @@
+# Banc de mesure des étapes lecture / emprise / rendu, résultats en JSON
+TARGET = DwgBench
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(DwgCommon.pri)
+
+SOURCES += \
+    benchmain.cpp
@@ -0,0 +1,91 @@
+# Configuration commune à la visionneuse et aux outils en ligne de commande :
+# services Teigha, rendu hors écran et utilitaires partagés.
+# Chaque projet définit TARGET avant d'inclure ce fichier.
+
+QT += core gui
+
+CONFIG += c++17 teigha
+
+# Plusieurs cibles sont construites dans le même dossier : objets séparés
+OBJECTS_DIR = .obj/$$TARGET
+MOC_DIR = .moc/$$TARGET
+RCC_DIR = .rcc/$$TARGET
+
+SOURCES += \
+    DwgExtents.cpp \
+    DwgMemory.cpp \
+    DwgOffscreenRenderer.cpp \
+    DwgPixelKernels.cpp \
+    DwgStripExport.cpp \
+    DwgTiffWriter.cpp \
+    DwgTileGrid.cpp \
+    DwgTrace.cpp \
+    MyServices.cpp \
+    ProcessMemory.cpp \
+    StaticModules.cpp
+
+HEADERS += \
+    DwgExtents.h \
+    DwgMemory.h \
+    DwgOffscreenRenderer.h \
+    DwgPixelKernels.h \
+    DwgStripExport.h \
+    DwgThreadScope.h \
+    DwgTiffWriter.h \
+    DwgTileGrid.h \
+    DwgTrace.h \
+    MyServices.h \
+    ProcessMemory.h \
+    StaticModules.h
+
+# Allocateur de Teigha : odrxAlloc / odrxRealloc / odrxFree sont fournis par
+# DwgMemory.cpp (pools par classe de taille, arène par document) et TD_Alloc
+# n'est pas lié. CONFIG += dwg_system_alloc revient à TD_Alloc.
+!dwg_system_alloc: DEFINES += DWG_POOLED_ALLOC
+
+# Mesure de la mémoire résidente (GetProcessMemoryInfo)
+win32: LIBS += -lpsapi
+
+# ===================================================================
+# Configuration de Teigha - À ADAPTER À VOTRE SYSTÈME
+# ===================================================================
+# Remplacez "C:/Teigha_26.10" par le chemin racine de votre installation Teigha.
+# TEIGHA_PATH = "C:/Teigha_26.10"
+
+# # Module de rendu OpenGL. Assurez-vous que le nom du module est correct pour votre version.
+# # Pour les versions récentes sur Windows, c'est généralement WinOpenGL.
+# # Pourrait être "WinDirectX", "MacOpenGL", etc. sur d'autres plateformes.
+# TEIGHA_GS_MODULE = "WinOpenGL.txv"
+
+# # Chemins vers les en-têtes (Headers)
+# INCLUDEPATH += $$TEIGHA_PATH/Kernel/Include
+# INCLUDEPATH += $$TEIGHA_PATH/Drawing/Include
+# INCLUDEPATH += $$TEIGHA_PATH/Drawing/Extensions/ExServices
+
+# # Chemins vers les bibliothèques (Libs) pour Windows / Visual Studio 2022
+# LIBS += -L$$TEIGHA_PATH/lib/vc17_amd64_16.0
+# LIBS += -L$$TEIGHA_PATH/thirdparty/lib/vc17_amd64_16.0
+
+# Bibliothèques Teigha requises (TD_Alloc seulement avec dwg_system_alloc)
+# dwg_system_alloc: LIBS += -lTD_Alloc.lib
+# LIBS += \
+#         -lTD_Db.lib \
+#         -lTD_DbRoot.lib \
+#         -lTD_ExamplesCommon.lib \
+#         -lTD_Ge.lib \
+#         -lTD_Gis.lib \
+#         -lTD_Gi.lib \
+#         -lTD_Gs.lib \
+#         -lTD_Root.lib \
+#         -lTD_SpatialIndex.lib
+
+# # Dépendances tierces
+# LIBS += -lFreeImage.lib \
+#         -lfreetype.lib
+
+# Copie des DLLs et modules nécessaires dans le répertoire de build
+# win32 {
+#     QMAKE_POST_LINK += copy /Y "$$replace(TEIGHA_PATH, /, \\)\\Kernel\\dll\\vc17_amd64_16.0\\TD_Alloc.dll" "$$replace(OUT_PWD, /, \\)" $$escape_expand(\\n\\t)
+#     QMAKE_POST_LINK += copy /Y "$$replace(TEIGHA_PATH, /, \\)\\Drawing\\dll\\vc17_amd64_16.0\\TD_Db.dll" "$$replace(OUT_PWD, /, \\)" $$escape_expand(\\n\\t)
+#     QMAKE_POST_LINK += copy /Y "$$replace(TEIGHA_PATH, /, \\)\\Platforms\\vc17_amd64_16.0\\$$TEIGHA_GS_MODULE" "$$replace(OUT_PWD, /, \\)" $$escape_expand(\\n\\t)
+# }
@@ -0,0 +1,345 @@
+#include "DwgDiskCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// En-tête des fichiers du cache : 32 octets, les pixels suivent directement
+// (alignement sur 4 octets : lecture directe dans les lignes de la QImage)
+struct TileFileHeader
+{
+    char magic[4];
+    quint32 version;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;
+    quint32 reserved[2];
+};
+static_assert(sizeof(TileFileHeader) == 32, "TileFileHeader must stay 32 bytes");
+
+const char kMagic[4] = { 'D', 'W', 'G', 'T' };
+const char kDataMagic[4] = { 'D', 'W', 'G', 'D' };
+
+// En-tête des données : taille utile, les octets suivent
+struct DataFileHeader
+{
+    char magic[4];
+    quint32 version;
+    qint64 size;
+};
+static_assert(sizeof(DataFileHeader) == 16, "DataFileHeader must stay 16 bytes");
+// 2 : tuiles en Format_RGB32 (auparavant BGR888, reconverties à chaque affichage)
+// 3 : empreinte des documents sur leurs extrémités (fileHash)
+const quint32 kVersion = 3;
+
+// Octets lus au début et à la fin d'un document pour son empreinte
+const qint64 kHashedEdgeBytes = 1024 * 1024;
+
+} // namespace
+
+DwgDiskCache& DwgDiskCache::instance()
+{
+    static DwgDiskCache cache;
+    return cache;
+}
+
+DwgDiskCache::DwgDiskCache()
+{
+    QSettings settings;
+    m_enabled = settings.value("cache/enabled", true).toBool();
+    m_directory = settings.value("cache/directory",
+                                 QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles").toString();
+    m_maxBytes = settings.value("cache/maxSizeMb", 2048).toLongLong() * 1024 * 1024;
+
+    if (m_enabled && !QDir().mkpath(m_directory)) {
+        qWarning() << "Disk cache disabled, cannot create" << m_directory;
+        m_enabled = false;
+    }
+}
+
+QByteArray DwgDiskCache::fileHash(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    // Taille, date et extrémités du fichier : un enregistrement change
+    // toujours la date, et l'en-tête comme la fin d'un DWG bougent avec le
+    // contenu. Lire tout le fichier retarderait la première tuile
+    const QFileInfo info(file);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint64 size = file.size();
+    hash.addData(QByteArray::number(size));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+
+    hash.addData(file.read(kHashedEdgeBytes));
+    if (size > 2 * kHashedEdgeBytes && file.seek(size - kHashedEdgeBytes))
+        hash.addData(file.read(kHashedEdgeBytes));
+    else
+        hash.addData(file.readAll());
+
+    return hash.result().toHex();
+}
+
+QByteArray DwgDiskCache::makeKey(const QByteArray& documentHash, const QString& layout, const QString& view)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(kVersion));
+    hash.addData(documentHash);
+    hash.addData(QByteArrayView("\0", 1));
+    hash.addData(layout.toUtf8());
+    hash.addData(QByteArrayView("\0", 1));
+    hash.addData(view.toUtf8());
+    return hash.result().toHex();
+}
+
+QString DwgDiskCache::pathFor(const QByteArray& key) const
+{
+    // Sous-répertoires sur les deux premiers caractères pour limiter la taille des dossiers
+    const QString name = QString::fromLatin1(key);
+    return m_directory + '/' + name.left(2) + '/' + name + ".tile";
+}
+
+void DwgDiskCache::ensureIndex()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_indexed)
+        return;
+
+    QDirIterator it(m_directory, QStringList() << "*.tile", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        Entry entry;
+        entry.size = info.size();
+        entry.lastUse = info.lastModified().toMSecsSinceEpoch();
+        m_entries.insert(info.completeBaseName(), entry);
+        m_totalBytes += entry.size;
+    }
+    m_indexed = true;
+    evict();
+}
+
+QImage DwgDiskCache::load(const QByteArray& key)
+{
+    if (!m_enabled || key.isEmpty())
+        return QImage();
+
+    ensureIndex();
+
+    QFile file(pathFor(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        ++m_misses;
+        return QImage();
+    }
+
+    // Lecture dans une image propre : une projection gardée par la QImage
+    // immobiliserait un descripteur par tuile en cache mémoire et
+    // empêcherait l'éviction du fichier sous Windows
+    const qint64 size = file.size();
+    TileFileHeader header;
+    bool valid = file.read(reinterpret_cast<char*>(&header), sizeof(header)) == qint64(sizeof(header))
+                 && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+                 && header.version == kVersion
+                 && header.width > 0 && header.height > 0
+                 && header.format > QImage::Format_Invalid && header.format < QImage::NImageFormats
+                 && header.bytesPerLine >= header.width
+                 && qint64(sizeof(header)) + qint64(header.bytesPerLine) * header.height <= size;
+
+    QImage image;
+    if (valid) {
+        image = QImage(header.width, header.height, QImage::Format(header.format));
+        valid = !image.isNull() && image.bytesPerLine() <= header.bytesPerLine;
+    }
+    if (valid && image.bytesPerLine() == header.bytesPerLine) {
+        const qint64 bytes = qint64(header.bytesPerLine) * header.height;
+        valid = file.read(reinterpret_cast<char*>(image.bits()), bytes) == bytes;
+    } else if (valid) {
+        // Pas de ligne différent de celui de QImage : copie ligne par ligne
+        const qint64 lineBytes = image.bytesPerLine();
+        for (int y = 0; y < header.height && valid; ++y) {
+            valid = file.seek(qint64(sizeof(header)) + qint64(header.bytesPerLine) * y)
+                    && file.read(reinterpret_cast<char*>(image.scanLine(y)), lineBytes) == lineBytes;
+        }
+    }
+
+    if (!valid) {
+        // Fichier tronqué ou d'une ancienne version : on le supprime
+        file.close();
+        file.remove();
+        forget(key);
+        ++m_misses;
+        return QImage();
+    }
+
+    touch(&file, key);
+    ++m_hits;
+    return image;
+}
+
+void DwgDiskCache::store(const QByteArray& key, const QImage& image)
+{
+    if (!m_enabled || key.isEmpty() || image.isNull())
+        return;
+
+    ensureIndex();
+
+    TileFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.width = image.width();
+    header.height = image.height();
+    header.bytesPerLine = int(image.bytesPerLine());
+    header.format = int(image.format());
+
+    write(key, &header, sizeof(header), reinterpret_cast<const char*>(image.constBits()), image.sizeInBytes());
+}
+
+QByteArray DwgDiskCache::loadData(const QByteArray& key)
+{
+    if (!m_enabled || key.isEmpty())
+        return QByteArray();
+
+    ensureIndex();
+
+    QFile file(pathFor(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        ++m_misses;
+        return QByteArray();
+    }
+
+    DataFileHeader header;
+    const bool valid = file.read(reinterpret_cast<char*>(&header), sizeof(header)) == qint64(sizeof(header))
+                       && std::memcmp(header.magic, kDataMagic, sizeof(kDataMagic)) == 0
+                       && header.version == kVersion
+                       && header.size >= 0 && qint64(sizeof(header)) + header.size == file.size();
+    if (!valid) {
+        file.close();
+        file.remove();
+        forget(key);
+        ++m_misses;
+        return QByteArray();
+    }
+
+    const QByteArray data = file.read(header.size);
+    touch(&file, key);
+    ++m_hits;
+    return data;
+}
+
+void DwgDiskCache::storeData(const QByteArray& key, const QByteArray& data)
+{
+    if (!m_enabled || key.isEmpty())
+        return;
+
+    ensureIndex();
+
+    DataFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kDataMagic, sizeof(kDataMagic));
+    header.version = kVersion;
+    header.size = data.size();
+    write(key, &header, sizeof(header), data.constData(), data.size());
+}
+
+bool DwgDiskCache::write(const QByteArray& key, const void* header, qint64 headerSize, const char* data, qint64 size)
+{
+    const QString path = pathFor(key);
+    QDir().mkpath(QFileInfo(path).path());
+
+    // Écriture atomique : un lecteur ne voit jamais de fichier partiel
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(static_cast<const char*>(header), headerSize);
+    file.write(data, size);
+    if (!file.commit()) {
+        qWarning() << "Disk cache write failed:" << path;
+        return false;
+    }
+    ++m_writes;
+
+    QMutexLocker lock(&m_mutex);
+    Entry& entry = m_entries[QString::fromLatin1(key)];
+    m_totalBytes -= entry.size;
+    entry.size = headerSize + size;
+    entry.lastUse = QDateTime::currentMSecsSinceEpoch();
+    m_totalBytes += entry.size;
+    evict();
+    return true;
+}
+
+void DwgDiskCache::forget(const QByteArray& key)
+{
+    QMutexLocker lock(&m_mutex);
+    const auto it = m_entries.find(QString::fromLatin1(key));
+    if (it != m_entries.end()) {
+        m_totalBytes -= it->size;
+        m_entries.erase(it);
+    }
+}
+
+void DwgDiskCache::touch(QFile* file, const QByteArray& key)
+{
+    // LRU : la date de modification sert de date de dernier accès
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    file->setFileTime(now, QFileDevice::FileModificationTime);
+
+    QMutexLocker lock(&m_mutex);
+    const auto it = m_entries.find(QString::fromLatin1(key));
+    if (it != m_entries.end())
+        it->lastUse = now.toMSecsSinceEpoch();
+}
+
+void DwgDiskCache::evict()
+{
+    // Appelé sous m_mutex
+    if (m_totalBytes <= m_maxBytes)
+        return;
+
+    QVector<QPair<qint64, QString>> byAge;
+    byAge.reserve(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+        byAge.append(qMakePair(it->lastUse, it.key()));
+    std::sort(byAge.begin(), byAge.end());
+
+    // On descend sous 90 % du budget pour ne pas évincer à chaque écriture
+    const qint64 target = m_maxBytes - m_maxBytes / 10;
+    for (const auto& candidate : byAge) {
+        if (m_totalBytes <= target)
+            break;
+        // Aucun fichier du cache ne reste ouvert : un échec (fichier déjà
+        // supprimé) ne se reproduira pas, l'entrée est oubliée quoi qu'il en soit
+        QFile::remove(pathFor(candidate.second.toLatin1()));
+        m_totalBytes -= m_entries.value(candidate.second).size;
+        m_entries.remove(candidate.second);
+        ++m_evictions;
+    }
+}
+
+DwgDiskCacheStats DwgDiskCache::stats() const
+{
+    DwgDiskCacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.writes = m_writes;
+    stats.evictions = m_evictions;
+    QMutexLocker lock(&m_mutex);
+    stats.bytes = m_totalBytes;
+    return stats;
+}
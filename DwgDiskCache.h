@@ -0,0 +1,89 @@
+#ifndef DWGDISKCACHE_H
+#define DWGDISKCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+
+class QFile;
+
+// Compteurs du cache disque, pour dimensionner le budget
+struct DwgDiskCacheStats
+{
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 writes = 0;
+    quint64 evictions = 0;
+    qint64 bytes = 0;
+};
+
+// Cache disque des images rendues, partagé par tous les documents.
+// La clé combine l'empreinte du contenu du fichier DWG, la présentation
+// active et les paramètres de vue. Les tuiles sont relues dans des images
+// propres (aucun fichier ne reste ouvert) et évincées par ordre
+// d'utilisation (LRU) au-delà du budget.
+// Réglages (QSettings) : cache/enabled, cache/directory, cache/maxSizeMb.
+class DwgDiskCache
+{
+public:
+    static DwgDiskCache& instance();
+
+    bool isEnabled() const { return m_enabled; }
+    QString directory() const { return m_directory; }
+    qint64 maxBytes() const { return m_maxBytes; }
+
+    // Empreinte d'un fichier : taille, date de modification, premier et
+    // dernier Mo (lecture rapide quelle que soit la taille du plan)
+    static QByteArray fileHash(const QString& filePath);
+
+    // Clé d'une image : empreinte du document + présentation + paramètres de vue
+    static QByteArray makeKey(const QByteArray& documentHash, const QString& layout, const QString& view);
+
+    // Image relue depuis le disque (copie propre, fichier refermé), nulle si absente
+    QImage load(const QByteArray& key);
+    void store(const QByteArray& key, const QImage& image);
+
+    // Petites données associées au document (emprise exacte...), même
+    // répertoire et même éviction que les images ; vide si absentes
+    QByteArray loadData(const QByteArray& key);
+    void storeData(const QByteArray& key, const QByteArray& data);
+
+    DwgDiskCacheStats stats() const;
+
+private:
+    DwgDiskCache();
+
+    struct Entry
+    {
+        qint64 size = 0;
+        qint64 lastUse = 0;
+    };
+
+    QString pathFor(const QByteArray& key) const;
+    void forget(const QByteArray& key);
+    void touch(QFile* file, const QByteArray& key);
+    bool write(const QByteArray& key, const void* header, qint64 headerSize, const char* data, qint64 size);
+    void ensureIndex();
+    void evict();
+
+    bool m_enabled = true;
+    QString m_directory;
+    qint64 m_maxBytes = 0;
+
+    // Protégé par m_mutex
+    mutable QMutex m_mutex;
+    bool m_indexed = false;
+    QHash<QString, Entry> m_entries;
+    qint64 m_totalBytes = 0;
+
+    std::atomic<quint64> m_hits { 0 };
+    std::atomic<quint64> m_misses { 0 };
+    std::atomic<quint64> m_writes { 0 };
+    std::atomic<quint64> m_evictions { 0 };
+};
+
+#endif // DWGDISKCACHE_H
@@ -0,0 +1,448 @@
+#include "DwgDisplayList.h"
+#include "DwgTrace.h"
+
+#include <QPainter>
+#include <QPen>
+
+#include <algorithm>
+#include <numeric>
+
+// Primitives par bloc : assez pour amortir le test d'emprise, assez peu
+// pour que les blocs hors écran soient écartés finement
+static const int kChunkSize = 128;
+
+// Instances par bloc d'instances
+static const int kInstanceChunkSize = 64;
+
+namespace {
+
+// Contrairement à QRectF::intersects, accepte les emprises de largeur ou hauteur nulle
+inline bool overlaps(const QRectF& a, const QRectF& b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+// Entrelace les bits de x et y (16 bits chacun) : ordre de Morton
+quint32 mortonCode(quint32 x, quint32 y)
+{
+    auto spread = [](quint32 v) {
+        v &= 0xffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+QRectF pointsBounds(const QPointF* points, int count)
+{
+    qreal minX = points[0].x(), maxX = minX;
+    qreal minY = points[0].y(), maxY = minY;
+    for (int i = 1; i < count; ++i) {
+        minX = qMin(minX, points[i].x());
+        maxX = qMax(maxX, points[i].x());
+        minY = qMin(minY, points[i].y());
+        maxY = qMax(maxY, points[i].y());
+    }
+    return QRectF(minX, minY, maxX - minX, maxY - minY);
+}
+
+QRectF unite(const QRectF& a, const QRectF& b)
+{
+    // QRectF::united ignore les rectangles de taille nulle
+    const qreal left = qMin(a.left(), b.left());
+    const qreal top = qMin(a.top(), b.top());
+    return QRectF(left, top, qMax(a.right(), b.right()) - left, qMax(a.bottom(), b.bottom()) - top);
+}
+
+// Ordre de parcours spatial de centres, normalisés sur bounds
+QVector<int> mortonOrder(const QVector<QPointF>& centers, const QRectF& bounds)
+{
+    const qreal sx = bounds.width() > 0.0 ? 65535.0 / bounds.width() : 0.0;
+    const qreal sy = bounds.height() > 0.0 ? 65535.0 / bounds.height() : 0.0;
+
+    QVector<quint32> codes(centers.size());
+    for (int i = 0; i < centers.size(); ++i) {
+        const QPointF& c = centers.at(i);
+        codes[i] = mortonCode(quint32(qBound(0.0, (c.x() - bounds.left()) * sx, 65535.0)),
+                              quint32(qBound(0.0, (c.y() - bounds.top()) * sy, 65535.0)));
+    }
+
+    QVector<int> order(centers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&codes](int a, int b) { return codes.at(a) < codes.at(b); });
+    return order;
+}
+
+// Stylo d'un lot de traits ; épaisseurs en pixels écran quel que soit le
+// zoom ou l'échelle de l'instance (stylo cosmétique)
+QPen batchPen(QRgb rgb, float widthPx)
+{
+    QPen pen(QColor::fromRgb(rgb), widthPx);
+    pen.setCosmetic(true);
+    pen.setCapStyle(Qt::RoundCap);
+    pen.setJoinStyle(Qt::RoundJoin);
+    return pen;
+}
+
+} // namespace
+
+qint64 DwgDisplayList::instancedPrimitiveCount() const
+{
+    qint64 count = 0;
+    for (const Instance& instance : m_instances)
+        count += m_prototypes.at(instance.prototype).primitiveCount;
+    return count;
+}
+
+qint64 DwgDisplayList::prototypePrimitiveCount() const
+{
+    qint64 count = 0;
+    for (const Prototype& prototype : m_prototypes)
+        count += prototype.primitiveCount;
+    return count;
+}
+
+qint64 DwgDisplayList::memoryBytes() const
+{
+    return qint64(m_points.capacity()) * sizeof(QPointF)
+         + qint64(m_primitives.capacity()) * sizeof(Primitive)
+         + qint64(m_chunks.capacity()) * sizeof(Chunk)
+         + qint64(m_batches.capacity() + m_prototypeBatches.capacity()) * sizeof(Batch)
+         + qint64(m_prototypes.capacity()) * sizeof(Prototype)
+         + qint64(m_instances.capacity()) * sizeof(Instance)
+         + qint64(m_instanceChunks.capacity()) * sizeof(Chunk);
+}
+
+void DwgDisplayList::paint(QPainter* painter, const QRectF& exposed, qreal pixelsPerUnit,
+                           const QVector<bool>& hiddenLayers) const
+{
+    DWG_TRACE_SPAN("displayListPaint");
+
+    const qreal onePixel = pixelsPerUnit > 0.0 ? 1.0 / pixelsPerUnit : 0.0;
+    // Géométrie sans calque (indice -1) toujours affichée
+    auto hidden = [&hiddenLayers](const Batch& batch) {
+        return batch.layer >= 0 && batch.layer < hiddenLayers.size() && hiddenLayers.at(batch.layer);
+    };
+
+    auto drawChunk = [&](const Batch& batch, const Chunk& chunk) {
+        for (int p = chunk.firstPrimitive; p < chunk.firstPrimitive + chunk.primitiveCount; ++p) {
+            const Primitive& primitive = m_primitives.at(p);
+            const QPointF* points = m_points.constData() + primitive.firstPoint;
+            if (batch.filled)
+                painter->drawPolygon(points, primitive.pointCount);
+            else
+                painter->drawPolyline(points, primitive.pointCount);
+        }
+    };
+    auto applyStyle = [&](const Batch& batch) {
+        painter->setPen(batch.filled ? QPen(Qt::NoPen) : batchPen(batch.color, batch.widthPx));
+        painter->setBrush(batch.filled ? QBrush(QColor::fromRgb(batch.color)) : QBrush(Qt::NoBrush));
+    };
+
+    painter->save();
+    for (const Batch& batch : m_batches) {
+        if (hidden(batch))
+            continue;
+        applyStyle(batch);
+        for (int c = batch.firstChunk; c < batch.firstChunk + batch.chunkCount; ++c) {
+            const Chunk& chunk = m_chunks.at(c);
+            if (!overlaps(chunk.bounds, exposed))
+                continue;
+
+            // Bloc entier plus petit qu'un pixel : un point suffit
+            if (chunk.bounds.width() < onePixel && chunk.bounds.height() < onePixel) {
+                painter->setPen(batchPen(batch.color, batch.widthPx));
+                painter->drawPoint(chunk.bounds.center());
+                applyStyle(batch);
+                continue;
+            }
+            drawChunk(batch, chunk);
+        }
+    }
+
+    // Instances de blocs : la géométrie partagée est rejouée sous la
+    // transformation de chaque insertion visible
+    const QTransform base = painter->worldTransform();
+    for (const Chunk& instanceChunk : m_instanceChunks) {
+        if (!overlaps(instanceChunk.bounds, exposed))
+            continue;
+
+        for (int i = instanceChunk.firstPrimitive; i < instanceChunk.firstPrimitive + instanceChunk.primitiveCount; ++i) {
+            const Instance& instance = m_instances.at(i);
+            if (!overlaps(instance.bounds, exposed))
+                continue;
+
+            const Prototype& prototype = m_prototypes.at(instance.prototype);
+            if (instance.bounds.width() < onePixel && instance.bounds.height() < onePixel) {
+                for (int b = prototype.firstBatch; b < prototype.firstBatch + prototype.batchCount; ++b) {
+                    const Batch& batch = m_prototypeBatches.at(b);
+                    if (hidden(batch))
+                        continue;
+                    painter->setWorldTransform(base);
+                    painter->setPen(batchPen(batch.color, batch.widthPx));
+                    painter->drawPoint(instance.bounds.center());
+                    break;
+                }
+                continue;
+            }
+
+            painter->setWorldTransform(instance.transform() * base);
+            for (int b = prototype.firstBatch; b < prototype.firstBatch + prototype.batchCount; ++b) {
+                const Batch& batch = m_prototypeBatches.at(b);
+                if (hidden(batch))
+                    continue;
+                applyStyle(batch);
+                drawChunk(batch, m_chunks.at(batch.firstChunk));
+            }
+        }
+    }
+    painter->setWorldTransform(base);
+    painter->restore();
+}
+
+// ---------------------------------------------------------------------------
+
+DwgDisplayListCollector::DwgDisplayListCollector()
+    : m_list(new DwgDisplayList())
+{
+}
+
+void DwgDisplayListCollector::setStyle(QRgb color, float widthPx, int layer)
+{
+    if (color == m_color && widthPx == m_widthPx && layer == m_layer)
+        return;
+    m_color = color;
+    m_widthPx = widthPx;
+    m_layer = layer;
+    m_lastBatch[0] = m_lastBatch[1] = -1;
+}
+
+void DwgDisplayListCollector::addPolyline(const QPointF* points, int count)
+{
+    if (count >= 2)
+        add(points, count, false);
+}
+
+void DwgDisplayListCollector::addPolygon(const QPointF* points, int count)
+{
+    if (count >= 3)
+        add(points, count, true);
+}
+
+void DwgDisplayListCollector::add(const QPointF* points, int count, bool filled)
+{
+    int& batchIndex = m_lastBatch[filled ? 1 : 0];
+    if (batchIndex < 0) {
+        const quint64 key = quint64(m_color & 0xffffff)
+                          | (quint64(qRound(m_widthPx * 100.0f) & 0xffff) << 24)
+                          | (quint64((m_layer + 1) & 0x7fffff) << 40)
+                          | (quint64(filled ? 1 : 0) << 63);
+        auto it = m_current->batchIndex.constFind(key);
+        if (it == m_current->batchIndex.constEnd()) {
+            PendingBatch batch;
+            batch.color = m_color;
+            batch.widthPx = m_widthPx;
+            batch.filled = filled;
+            batch.layer = m_layer;
+            batch.starts.append(0);
+            m_current->batches.append(batch);
+            it = m_current->batchIndex.insert(key, m_current->batches.size() - 1);
+        }
+        batchIndex = it.value();
+    }
+
+    PendingBatch& batch = m_current->batches[batchIndex];
+    batch.points.append(points, count);
+    batch.starts.append(batch.points.size());
+}
+
+void DwgDisplayListCollector::beginPrototype()
+{
+    m_capture.clear();
+    m_current = &m_capture;
+    m_lastBatch[0] = m_lastBatch[1] = -1;
+}
+
+int DwgDisplayListCollector::endPrototype(const QTransform& toItem)
+{
+    m_current = &m_main;
+    m_lastBatch[0] = m_lastBatch[1] = -1;
+
+    bool invertible = false;
+    const QTransform toBlock = toItem.inverted(&invertible);
+    DwgDisplayList& list = *m_list;
+
+    DwgDisplayList::Prototype prototype;
+    prototype.firstBatch = list.m_prototypeBatches.size();
+    bool hasBounds = false;
+
+    // Surfaces pleines d'abord, comme pour la géométrie principale
+    std::stable_sort(m_capture.batches.begin(), m_capture.batches.end(),
+                     [](const PendingBatch& a, const PendingBatch& b) { return a.filled && !b.filled; });
+
+    for (const PendingBatch& pending : m_capture.batches) {
+        const int count = pending.starts.size() - 1;
+        if (count <= 0 || !invertible)
+            continue;
+
+        DwgDisplayList::Chunk chunk;
+        chunk.firstPrimitive = list.m_primitives.size();
+        chunk.primitiveCount = count;
+
+        const int firstPoint = list.m_points.size();
+        list.m_points.reserve(firstPoint + pending.points.size());
+        for (const QPointF& point : pending.points)
+            list.m_points.append(toBlock.map(point));
+        for (int i = 0; i < count; ++i) {
+            DwgDisplayList::Primitive primitive;
+            primitive.firstPoint = firstPoint + pending.starts.at(i);
+            primitive.pointCount = pending.starts.at(i + 1) - pending.starts.at(i);
+            list.m_primitives.append(primitive);
+        }
+        chunk.bounds = pointsBounds(list.m_points.constData() + firstPoint, pending.points.size());
+        prototype.bounds = hasBounds ? unite(prototype.bounds, chunk.bounds) : chunk.bounds;
+        hasBounds = true;
+
+        DwgDisplayList::Batch batch;
+        batch.color = pending.color;
+        batch.widthPx = pending.widthPx;
+        batch.filled = pending.filled;
+        batch.layer = pending.layer;
+        batch.firstChunk = list.m_chunks.size();
+        batch.chunkCount = 1;
+        list.m_chunks.append(chunk);
+        list.m_prototypeBatches.append(batch);
+
+        prototype.primitiveCount += count;
+    }
+    m_capture.clear();
+
+    prototype.batchCount = list.m_prototypeBatches.size() - prototype.firstBatch;
+    if (prototype.batchCount == 0)
+        return -1;
+    list.m_prototypes.append(prototype);
+    return list.m_prototypes.size() - 1;
+}
+
+void DwgDisplayListCollector::addInstance(int prototype, const QTransform& toItem)
+{
+    if (prototype < 0)
+        return;
+
+    DwgDisplayList::Instance instance;
+    instance.m11 = toItem.m11();
+    instance.m12 = toItem.m12();
+    instance.m21 = toItem.m21();
+    instance.m22 = toItem.m22();
+    instance.dx = toItem.dx();
+    instance.dy = toItem.dy();
+    instance.prototype = prototype;
+    instance.bounds = toItem.mapRect(m_list->m_prototypes.at(prototype).bounds);
+    m_instances.append(instance);
+}
+
+DwgDisplayListPtr DwgDisplayListCollector::finish(const QStringList& layerNames)
+{
+    std::unique_ptr<DwgDisplayList> list = std::move(m_list);
+    m_list.reset(new DwgDisplayList());
+    list->m_layerNames = layerNames;
+
+    // Emprise globale pour normaliser les codes de Morton
+    bool hasBounds = false;
+    QRectF bounds;
+    for (const PendingBatch& batch : m_main.batches) {
+        if (batch.points.isEmpty())
+            continue;
+        const QRectF b = pointsBounds(batch.points.constData(), batch.points.size());
+        bounds = hasBounds ? unite(bounds, b) : b;
+        hasBounds = true;
+    }
+    for (const DwgDisplayList::Instance& instance : m_instances) {
+        bounds = hasBounds ? unite(bounds, instance.bounds) : instance.bounds;
+        hasBounds = true;
+    }
+    list->m_bounds = bounds;
+
+    // Surfaces pleines d'abord : les traits restent visibles par-dessus
+    QVector<int> order(m_main.batches.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_main.batches.at(a).filled && !m_main.batches.at(b).filled;
+    });
+
+    for (int batchIndex : order) {
+        const PendingBatch& pending = m_main.batches.at(batchIndex);
+        const int count = pending.starts.size() - 1;
+        if (count <= 0)
+            continue;
+
+        QVector<QRectF> primitiveBounds(count);
+        QVector<QPointF> centers(count);
+        for (int i = 0; i < count; ++i) {
+            const int first = pending.starts.at(i);
+            primitiveBounds[i] = pointsBounds(pending.points.constData() + first, pending.starts.at(i + 1) - first);
+            centers[i] = primitiveBounds.at(i).center();
+        }
+
+        // Primitives voisines dans le plan => voisines dans les tableaux
+        const QVector<int> sorted = mortonOrder(centers, bounds);
+
+        DwgDisplayList::Batch batch;
+        batch.color = pending.color;
+        batch.widthPx = pending.widthPx;
+        batch.filled = pending.filled;
+        batch.layer = pending.layer;
+        batch.firstChunk = list->m_chunks.size();
+
+        for (int start = 0; start < count; start += kChunkSize) {
+            DwgDisplayList::Chunk chunk;
+            chunk.firstPrimitive = list->m_primitives.size();
+            chunk.primitiveCount = qMin(kChunkSize, count - start);
+            for (int i = start; i < start + chunk.primitiveCount; ++i) {
+                const int index = sorted.at(i);
+                const int first = pending.starts.at(index);
+                DwgDisplayList::Primitive primitive;
+                primitive.firstPoint = list->m_points.size();
+                primitive.pointCount = pending.starts.at(index + 1) - first;
+                list->m_points.append(pending.points.constData() + first, primitive.pointCount);
+                list->m_primitives.append(primitive);
+                chunk.bounds = i == start ? primitiveBounds.at(index) : unite(chunk.bounds, primitiveBounds.at(index));
+            }
+            list->m_chunks.append(chunk);
+        }
+        batch.chunkCount = list->m_chunks.size() - batch.firstChunk;
+        list->m_batches.append(batch);
+    }
+
+    // Instances rangées de la même façon, par blocs avec leur emprise
+    QVector<QPointF> centers(m_instances.size());
+    for (int i = 0; i < m_instances.size(); ++i)
+        centers[i] = m_instances.at(i).bounds.center();
+    const QVector<int> sorted = mortonOrder(centers, bounds);
+    list->m_instances.reserve(m_instances.size());
+    for (int start = 0; start < sorted.size(); start += kInstanceChunkSize) {
+        DwgDisplayList::Chunk chunk;
+        chunk.firstPrimitive = list->m_instances.size();
+        chunk.primitiveCount = qMin(kInstanceChunkSize, int(sorted.size()) - start);
+        for (int i = start; i < start + chunk.primitiveCount; ++i) {
+            const DwgDisplayList::Instance& instance = m_instances.at(sorted.at(i));
+            list->m_instances.append(instance);
+            chunk.bounds = i == start ? instance.bounds : unite(chunk.bounds, instance.bounds);
+        }
+        list->m_instanceChunks.append(chunk);
+    }
+
+    m_main.clear();
+    m_capture.clear();
+    m_current = &m_main;
+    m_instances.clear();
+    m_lastBatch[0] = m_lastBatch[1] = -1;
+
+    list->m_points.squeeze();
+    list->m_primitives.squeeze();
+    list->m_chunks.squeeze();
+    return DwgDisplayListPtr(list.release());
+}
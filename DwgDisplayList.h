@@ -0,0 +1,183 @@
+#include "OdaCommon.h"
+
+#ifndef DWGDISPLAYLIST_H
+#define DWGDISPLAYLIST_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QPointF>
+#include <QRectF>
+#include <QRgb>
+#include <QStringList>
+#include <QTransform>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "DbDatabase.h"
+
+class QPainter;
+
+// Géométrie du dessin vectorisée une fois par Teigha puis rejouée avec
+// QPainter à n'importe quel zoom, sans retourner dans le pipeline GS.
+// Tout est stocké dans des tableaux plats : points, primitives (polylignes
+// ou polygones pleins), blocs de primitives voisines avec leur emprise, et
+// lots de blocs partageant le même style (couleur, épaisseur, calque).
+// Les textes arrivent déjà décomposés en polylignes / polygones.
+// L'ordre de tracé n'est pas celui du dessin : toutes les surfaces pleines,
+// puis tous les traits, puis les instances, chaque lot rangé par proximité.
+// Un masque (wipeout, hachure pleine) placé par DRAWORDER au-dessus d'autres
+// entités ne les cache donc pas ; seules les tuiles raster le respectent.
+// Les insertions de blocs répétées sont des instances : une transformation
+// et une référence vers la géométrie du bloc (prototype), vectorisée une
+// seule fois par combinaison bloc / calque / couleur / épaisseur / type de ligne.
+// Immuable une fois construite : partageable entre threads.
+// Coordonnées item (Y dessin inversé).
+class DwgDisplayList
+{
+public:
+    int primitiveCount() const { return m_primitives.size(); }
+
+    // Statistiques d'instanciation des blocs
+    int prototypeCount() const { return m_prototypes.size(); }
+    int instanceCount() const { return m_instances.size(); }
+    // Primitives que les instances auraient stockées sans partage,
+    // et celles réellement stockées dans les prototypes
+    qint64 instancedPrimitiveCount() const;
+    qint64 prototypePrimitiveCount() const;
+
+    qint64 memoryBytes() const;
+    QRectF bounds() const { return m_bounds; }
+    const QStringList& layerNames() const { return m_layerNames; }
+
+    // Rejoue les blocs qui touchent exposed, lot par lot (ordre de tracé
+    // ci-dessus) ; pixelsPerUnit sert à réduire
+    // à un point les blocs plus petits qu'un pixel. Les lots des calques
+    // marqués dans hiddenLayers (indices de layerNames()) sont ignorés :
+    // masquer un calque ne demande aucune nouvelle vectorisation
+    void paint(QPainter* painter, const QRectF& exposed, qreal pixelsPerUnit,
+               const QVector<bool>& hiddenLayers = QVector<bool>()) const;
+
+    // Vectorise l'espace objet (vue de dessus sur bounds) ; nul en cas
+    // d'échec, d'interruption ou si une présentation est active
+    static std::shared_ptr<const DwgDisplayList> build(OdDbDatabase* pDb, const QRectF& bounds,
+                                                       const std::atomic<bool>* pAbort);
+
+private:
+    friend class DwgDisplayListCollector;
+
+    struct Primitive
+    {
+        int firstPoint = 0;
+        int pointCount = 0;
+    };
+
+    struct Chunk
+    {
+        QRectF bounds;
+        int firstPrimitive = 0;
+        int primitiveCount = 0;
+    };
+
+    // Transformation affine 2D d'une instance (convention QTransform)
+    struct Instance
+    {
+        double m11, m12, m21, m22, dx, dy;
+        QRectF bounds;
+        int prototype;
+
+        QTransform transform() const { return QTransform(m11, m12, m21, m22, dx, dy); }
+    };
+
+    // Géométrie d'un bloc, dans le repère du bloc (Y inversé) :
+    // des lots d'un seul bloc de primitives, rangés dans m_prototypeBatches
+    struct Prototype
+    {
+        QRectF bounds;
+        int firstBatch = 0;
+        int batchCount = 0;
+        int primitiveCount = 0;
+    };
+
+    struct Batch
+    {
+        QRgb color = 0;
+        float widthPx = 0.0f;       // 0 : trait fin
+        bool filled = false;
+        int layer = -1;             // Indice dans layerNames()
+        int firstChunk = 0;
+        int chunkCount = 0;
+    };
+
+    QVector<QPointF> m_points;
+    QVector<Primitive> m_primitives;
+    QVector<Chunk> m_chunks;
+    QVector<Batch> m_batches;
+    QVector<Prototype> m_prototypes;
+    QVector<Batch> m_prototypeBatches;
+    QVector<Instance> m_instances;
+    QVector<Chunk> m_instanceChunks;    // Primitives = instances ici
+    QStringList m_layerNames;
+    QRectF m_bounds;
+};
+
+typedef std::shared_ptr<const DwgDisplayList> DwgDisplayListPtr;
+Q_DECLARE_METATYPE(DwgDisplayListPtr)
+
+// Accumule la géométrie reçue du vectoriseur, lot par lot, puis la range
+// par proximité spatiale pour produire les blocs de la liste d'affichage
+class DwgDisplayListCollector
+{
+public:
+    DwgDisplayListCollector();
+
+    void setStyle(QRgb color, float widthPx, int layer);
+    void addPolyline(const QPointF* points, int count);
+    void addPolygon(const QPointF* points, int count);
+
+    // Capture de la géométrie d'un bloc : entre begin et end, les primitives
+    // (en coordonnées item) vont au prototype, ramenées dans le repère du bloc
+    // par l'inverse de toItem. Renvoie l'indice du prototype, -1 s'il est vide
+    void beginPrototype();
+    int endPrototype(const QTransform& toItem);
+    bool isCapturing() const { return m_current == &m_capture; }
+
+    void addInstance(int prototype, const QTransform& toItem);
+
+    DwgDisplayListPtr finish(const QStringList& layerNames);
+
+private:
+    struct PendingBatch
+    {
+        QRgb color = 0;
+        float widthPx = 0.0f;
+        bool filled = false;
+        int layer = -1;
+        QVector<QPointF> points;
+        QVector<int> starts;        // Premier point de chaque primitive (+ fin)
+    };
+
+    struct PendingGeometry
+    {
+        QVector<PendingBatch> batches;
+        QHash<quint64, int> batchIndex;
+        void clear() { batches.clear(); batchIndex.clear(); }
+    };
+
+    void add(const QPointF* points, int count, bool filled);
+
+    QRgb m_color = 0;
+    float m_widthPx = 0.0f;
+    int m_layer = -1;
+    PendingGeometry m_main;
+    PendingGeometry m_capture;
+    PendingGeometry* m_current = &m_main;
+    int m_lastBatch[2] = { -1, -1 };     // Dernier lot utilisé, trait / plein
+
+    // Prototypes finalisés au fil de la vectorisation, instances en attente de tri
+    std::unique_ptr<DwgDisplayList> m_list;
+    QVector<DwgDisplayList::Instance> m_instances;
+};
+
+#endif // DWGDISPLAYLIST_H
@@ -0,0 +1,290 @@
+#include "DwgDisplayList.h"
+#include "DwgOffscreenRenderer.h"
+#include "DwgTrace.h"
+
+#include <QDebug>
+#include <QtMath>
+
+#include <cmath>
+
+#include "ColorMapping.h"
+#include "DbBlockReference.h"
+#include "DbGsManager.h"
+#include "DbLayerTableRecord.h"
+#include "DbMInsertBlock.h"
+#include "DbObjectIterator.h"
+#include "Gi/GiGeometrySimplifier.h"
+#include "Gs/GsBaseVectorizer.h"
+#include "RxObjectImpl.h"
+
+// Vectorisation vers DwgDisplayList : un device GS minimal dont la vue
+// reçoit la géométrie simplifiée (polylignes, polygones pleins) en
+// coordonnées monde, quel que soit le zoom.
+// Les insertions de blocs du niveau supérieur sont instanciées : la première
+// insertion d'un bloc avec un style donné est vectorisée dans un prototype,
+// les suivantes ne produisent qu'une transformation.
+
+namespace {
+
+// Résolution de la vue de vectorisation : fixe la finesse de tessellation des courbes
+const int kVectorizeResolution = 16384;
+
+class DisplayListDevice;
+
+// Ce qui change la géométrie d'un bloc vectorisé : le bloc, le style hérité
+// par ses entités "DuBloc" / calque 0, et l'ordre de grandeur de l'échelle
+// (finesse de tessellation, motifs des types de ligne)
+struct PrototypeKey
+{
+    OdDbStub* block;
+    OdDbStub* layer;
+    OdDbStub* linetype;
+    OdUInt32 color;
+    int lineWeight;
+    double linetypeScale;
+    int scaleLevel;
+
+    bool operator==(const PrototypeKey& other) const
+    {
+        return block == other.block && layer == other.layer && linetype == other.linetype
+            && color == other.color && lineWeight == other.lineWeight
+            && linetypeScale == other.linetypeScale && scaleLevel == other.scaleLevel;
+    }
+};
+
+inline uint qHash(const PrototypeKey& key, uint seed = 0)
+{
+    return ::qHash(quintptr(key.block), seed) ^ ::qHash(quintptr(key.layer))
+         ^ ::qHash(key.color) ^ ::qHash(key.scaleLevel * 31 + key.lineWeight);
+}
+
+class DisplayListView : public OdGsBaseVectorizeViewDef, public OdGiGeometrySimplifier
+{
+public:
+    void beginViewVectorization() override;
+    void onTraitsModified() override;
+    bool doDraw(OdUInt32 drawableFlags, const OdGiDrawable* pDrawable) override;
+    void polylineDc(OdInt32 numPoints, const OdGePoint3d* vertexList) override;
+    void polygonDc(OdInt32 numPoints, const OdGePoint3d* vertexList, const OdGeVector3d* pNormal = 0) override;
+
+private:
+    DisplayListDevice* displayListDevice();
+    const QPointF* toItem(OdInt32 numPoints, const OdGePoint3d* vertexList);
+    bool drawInstance(OdUInt32 drawableFlags, const OdDbBlockReference* pRef);
+
+    QVector<QPointF> m_buffer;
+    int m_insertDepth = 0;
+};
+
+class DisplayListDevice : public OdGsBaseVectorizeDevice
+{
+public:
+    OdGsViewPtr createView(const OdGsClientViewInfo* pViewInfo = 0, bool bEnableLayerVisibilityPerView = false) override
+    {
+        OdGsViewPtr pView = OdRxObjectImpl<DisplayListView, OdGsView>::createObject();
+        static_cast<DisplayListView*>(pView.get())->init(this, pViewInfo, bEnableLayerVisibilityPerView);
+        return pView;
+    }
+
+    int layerIndex(OdDbStub* layerStub)
+    {
+        auto it = m_layers.constFind(layerStub);
+        if (it != m_layers.constEnd())
+            return it.value();
+
+        QString name;
+        if (layerStub) {
+            OdDbLayerTableRecordPtr pLayer = OdDbObjectId(layerStub).openObject();
+            if (!pLayer.isNull())
+                name = QString::fromWCharArray((const wchar_t*)pLayer->getName().c_str());
+        }
+        layerNames.append(name);
+        return m_layers.insert(layerStub, layerNames.size() - 1).value();
+    }
+
+    DwgDisplayListCollector collector;
+    QStringList layerNames;
+    QHash<PrototypeKey, int> prototypes;    // -> indice du prototype, -1 si vide
+
+private:
+    QHash<OdDbStub*, int> m_layers;
+};
+
+DisplayListDevice* DisplayListView::displayListDevice()
+{
+    return static_cast<DisplayListDevice*>(OdGsBaseVectorizeView::device());
+}
+
+void DisplayListView::beginViewVectorization()
+{
+    OdGsBaseVectorizeView::beginViewVectorization();
+
+    // Sortie en coordonnées monde plutôt qu'en pixels : la liste ne dépend pas du zoom
+    setEyeToOutputTransform(getEyeToWorldTransform());
+    OdGiGeometrySimplifier::setDrawContext(OdGsBaseVectorizeView::drawContext());
+    output().setDestGeometry(*this);
+}
+
+void DisplayListView::onTraitsModified()
+{
+    OdGsBaseVectorizeView::onTraitsModified();
+
+    const OdGiSubEntityTraitsData& traits = effectiveTraits();
+    const OdCmEntityColor color = traits.trueColor();
+    ODCOLORREF rgb;
+    if (color.isByColor())
+        rgb = ODRGB(color.red(), color.green(), color.blue());
+    else
+        rgb = displayListDevice()->getColor(OdUInt16(color.colorIndex()));
+
+    // Épaisseur en 1/100 mm, affichée à 96 dpi ; les valeurs "par défaut" restent en trait fin
+    const int lineWeight = traits.lineWeight() > 0 ? int(traits.lineWeight()) : 0;
+    displayListDevice()->collector.setStyle(qRgb(ODGETRED(rgb), ODGETGREEN(rgb), ODGETBLUE(rgb)),
+                                            lineWeight * 96.0f / 2540.0f,
+                                            displayListDevice()->layerIndex(traits.layer()));
+}
+
+bool DisplayListView::doDraw(OdUInt32 drawableFlags, const OdGiDrawable* pDrawable)
+{
+    OdDbBlockReferencePtr pRef = OdDbBlockReference::cast(pDrawable);
+    if (pRef.isNull())
+        return OdGsBaseVectorizeViewDef::doDraw(drawableFlags, pDrawable);
+
+    // Les blocs imbriqués suivent leur parent : géométrie du prototype ou dessin direct
+    if (m_insertDepth == 0 && !displayListDevice()->collector.isCapturing() && drawInstance(drawableFlags, pRef))
+        return true;
+
+    ++m_insertDepth;
+    const bool drawn = OdGsBaseVectorizeViewDef::doDraw(drawableFlags, pDrawable);
+    --m_insertDepth;
+    return drawn;
+}
+
+// Faux si l'insertion doit être vectorisée normalement
+bool DisplayListView::drawInstance(OdUInt32 drawableFlags, const OdDbBlockReference* pRef)
+{
+    // Attributs propres à chaque insertion, grilles MINSERT, découpes de xref : pas de partage
+    if (pRef->isKindOf(OdDbMInsertBlock::desc()) || !pRef->extensionDictionary().isNull())
+        return false;
+    OdDbObjectIteratorPtr pAttributes = pRef->attributeIterator();
+    if (!pAttributes.isNull() && !pAttributes->done())
+        return false;
+
+    // Transformation bloc -> monde, limitée au plan : la vue est une vue de dessus
+    const OdGeMatrix3d m = getModelToWorldTransform() * pRef->blockTransform();
+    if (!OdZero(m(0, 2)) || !OdZero(m(1, 2)) || !OdZero(m(2, 0)) || !OdZero(m(2, 1)))
+        return false;
+
+    // Même transformation en coordonnées item (Y inversé des deux côtés)
+    const QTransform toItem(m(0, 0), -m(1, 0), -m(0, 1), m(1, 1), m(0, 3), -m(1, 3));
+    const qreal scale = qSqrt(qAbs(toItem.determinant()));
+    if (scale <= 0.0)
+        return false;
+
+    PrototypeKey key;
+    key.block = pRef->blockTableRecord();
+    key.layer = pRef->layerId();
+    key.linetype = pRef->linetypeId();
+    key.color = pRef->color().color();
+    key.lineWeight = int(pRef->lineWeight());
+    key.linetypeScale = pRef->linetypeScale();
+    key.scaleLevel = qFloor(std::log2(scale));
+
+    DisplayListDevice* pDevice = displayListDevice();
+    auto it = pDevice->prototypes.constFind(key);
+    if (it == pDevice->prototypes.constEnd()) {
+        // Première occurrence : vectorisée une fois, ramenée dans le repère du bloc
+        pDevice->collector.beginPrototype();
+        ++m_insertDepth;
+        OdGsBaseVectorizeViewDef::doDraw(drawableFlags, pRef);
+        --m_insertDepth;
+        it = pDevice->prototypes.insert(key, pDevice->collector.endPrototype(toItem));
+    }
+    pDevice->collector.addInstance(it.value(), toItem);
+    return true;
+}
+
+const QPointF* DisplayListView::toItem(OdInt32 numPoints, const OdGePoint3d* vertexList)
+{
+    // Coordonnées item = coordonnées dessin avec l'axe Y inversé
+    m_buffer.resize(numPoints);
+    for (OdInt32 i = 0; i < numPoints; ++i)
+        m_buffer[i] = QPointF(vertexList[i].x, -vertexList[i].y);
+    return m_buffer.constData();
+}
+
+void DisplayListView::polylineDc(OdInt32 numPoints, const OdGePoint3d* vertexList)
+{
+    displayListDevice()->collector.addPolyline(toItem(numPoints, vertexList), numPoints);
+}
+
+void DisplayListView::polygonDc(OdInt32 numPoints, const OdGePoint3d* vertexList, const OdGeVector3d* /*pNormal*/)
+{
+    displayListDevice()->collector.addPolygon(toItem(numPoints, vertexList), numPoints);
+}
+
+} // namespace
+
+DwgDisplayListPtr DwgDisplayList::build(OdDbDatabase* pDb, const QRectF& bounds, const std::atomic<bool>* pAbort)
+{
+    if (!pDb || bounds.isEmpty())
+        return DwgDisplayListPtr();
+
+    DWG_TRACE_SPAN("displayList");
+
+    try {
+        // Comme pour l'index spatial : les fenêtres de présentation ne sont pas gérées
+        if (pDb->getActiveLayoutBTRId() != pDb->getModelSpaceId()) {
+            DwgTrace::counter("displayListSkipped", 1);
+            return DwgDisplayListPtr();
+        }
+
+        OdGsDevicePtr pDevice = OdRxObjectImpl<DisplayListDevice, OdGsDevice>::createObject();
+        DisplayListDevice* pListDevice = static_cast<DisplayListDevice*>(pDevice.get());
+        const ODCOLORREF background = ODRGB(255, 255, 255);
+        pDevice->setLogicalPalette(odcmAcadPalette(background), 256);
+        pDevice->setBackgroundColor(background);
+
+        // Vectorisation unique : pas de cache GS à conserver
+        DwgGiContextPtr pGiCtx = OdRxObjectImpl<DwgGiContext>::createObject();
+        pGiCtx->setDatabase(pDb);
+        pGiCtx->enableGsModel(false);
+        pGiCtx->setAbortFlag(pAbort);
+
+        OdGsLayoutHelperPtr pHelper = OdDbGsManager::setupActiveLayoutViews(pDevice, pGiCtx);
+        if (pHelper.isNull())
+            return DwgDisplayListPtr();
+
+        OdGsDCRect rect(0, kVectorizeResolution, kVectorizeResolution, 0);
+        pHelper->onSize(rect);
+
+        OdGsViewPtr pView = pHelper->activeView();
+        if (pView.isNull())
+            return DwgDisplayListPtr();
+
+        // Vue de dessus sur toute l'emprise : aucune entité n'est écartée
+        const QPointF center = bounds.center();
+        OdGePoint3d target(center.x(), -center.y(), 0.0);
+        pView->setView(target + OdGeVector3d::kZAxis, target, OdGeVector3d::kYAxis,
+                       bounds.width(), bounds.height());
+
+        pDevice->update();
+        if (pAbort && pAbort->load(std::memory_order_relaxed))
+            return DwgDisplayListPtr();
+
+        DwgDisplayListPtr list = pListDevice->collector.finish(pListDevice->layerNames);
+        DwgTrace::counter("displayListPrimitives", list->primitiveCount());
+        DwgTrace::counter("displayListKb", list->memoryBytes() / 1024);
+        DwgTrace::counter("displayListInstances", list->instanceCount());
+        DwgTrace::counter("displayListPrototypes", list->prototypeCount());
+        DwgTrace::counter("displayListSharedPrimitives",
+                          list->instancedPrimitiveCount() - list->prototypePrimitiveCount());
+        return list;
+
+    } catch (const OdError& e) {
+        qWarning() << "Display list error:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+    } catch (...) {
+        qWarning() << "Unknown display list error";
+    }
+    return DwgDisplayListPtr();
+}
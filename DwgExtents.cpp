@@ -0,0 +1,114 @@
+#include "DwgExtents.h"
+#include "DwgTrace.h"
+#include "DbLayout.h"
+#include "Ge/GeExtents3d.h"
+#include "Ge/GePoint2d.h"
+
+namespace DwgExtents
+{
+
+namespace {
+
+// Coordonnées item = coordonnées dessin avec l'axe Y inversé ; une emprise
+// quasi ponctuelle est élargie pour garder une échelle d'affichage raisonnable
+QRectF toItemRect(OdGePoint2d min, OdGePoint2d max)
+{
+    if(min.distanceTo(max) < 1.0) {
+        min.x -= 50.0;
+        min.y -= 50.0;
+        max.x += 50.0;
+        max.y += 50.0;
+    }
+    return QRectF(min.x, -max.y, max.x - min.x, max.y - min.y);
+}
+
+// Les variables non renseignées valent +/-1e20 (min > max)
+bool isValidHeaderRange(const OdGePoint2d& min, const OdGePoint2d& max)
+{
+    const double limit = 1.0e19;
+    return min.x <= max.x && min.y <= max.y
+        && qAbs(min.x) < limit && qAbs(min.y) < limit && qAbs(max.x) < limit && qAbs(max.y) < limit;
+}
+
+} // namespace
+
+QRectF exactBounds(OdDbDatabase* pDb)
+{
+    if(!pDb)
+        return QRectF();
+
+    DWG_TRACE_SPAN("getGeomExtents");
+
+    try {
+        OdGeExtents3d extents;
+        if(pDb->getGeomExtents(extents) == eOk && extents.isValidExtents()) {
+            const OdGePoint3d min = extents.minPoint();
+            const OdGePoint3d max = extents.maxPoint();
+            return toItemRect(OdGePoint2d(min.x, min.y), OdGePoint2d(max.x, max.y));
+        }
+    } catch(...) {
+    }
+    return QRectF();
+}
+
+QRectF headerBounds(OdDbDatabase* pDb)
+{
+    if(!pDb)
+        return QRectF();
+
+    try {
+        const bool modelSpace = pDb->getActiveLayoutBTRId() == pDb->getModelSpaceId();
+        const OdGePoint3d extMin = modelSpace ? pDb->getEXTMIN() : pDb->getPEXTMIN();
+        const OdGePoint3d extMax = modelSpace ? pDb->getEXTMAX() : pDb->getPEXTMAX();
+        const OdGePoint2d min(extMin.x, extMin.y);
+        const OdGePoint2d max(extMax.x, extMax.y);
+        if(isValidHeaderRange(min, max))
+            return toItemRect(min, max);
+
+        const OdGePoint2d limMin = modelSpace ? pDb->getLIMMIN() : pDb->getPLIMMIN();
+        const OdGePoint2d limMax = modelSpace ? pDb->getLIMMAX() : pDb->getPLIMMAX();
+        if(isValidHeaderRange(limMin, limMax))
+            return toItemRect(limMin, limMax);
+    } catch(...) {
+    }
+    return QRectF();
+}
+
+QRectF layoutBounds(OdDbDatabase* pDb, const OdDbObjectId& layoutId)
+{
+    if(!pDb || layoutId.isNull())
+        return QRectF();
+
+    try {
+        OdDbLayoutPtr pLayout = layoutId.safeOpenObject();
+        const OdDbObjectId blockId = pLayout->getBlockTableRecordId();
+        // Présentation active : l'en-tête est à jour (EXTMIN ou PEXTMIN)
+        if(blockId == pDb->getActiveLayoutBTRId())
+            return headerBounds(pDb);
+
+        if(blockId == pDb->getModelSpaceId()) {
+            const OdGePoint3d extMin = pDb->getEXTMIN();
+            const OdGePoint3d extMax = pDb->getEXTMAX();
+            const OdGePoint2d min(extMin.x, extMin.y);
+            const OdGePoint2d max(extMax.x, extMax.y);
+            if(isValidHeaderRange(min, max))
+                return toItemRect(min, max);
+        } else {
+            OdGePoint3d extMin, extMax;
+            pLayout->getExtents(extMin, extMax);
+            const OdGePoint2d min(extMin.x, extMin.y);
+            const OdGePoint2d max(extMax.x, extMax.y);
+            if(isValidHeaderRange(min, max))
+                return toItemRect(min, max);
+        }
+
+        OdGePoint2d limMin, limMax;
+        pLayout->getLimits(limMin, limMax);
+        if(isValidHeaderRange(limMin, limMax))
+            return toItemRect(limMin, limMax);
+    } catch(...) {
+    }
+    return QRectF();
+}
+
+} // namespace DwgExtents
@@ -0,0 +1,27 @@
+#include "OdaCommon.h"
+
+#ifndef DWGEXTENTS_H
+#define DWGEXTENTS_H
+
+#include <QRectF>
+
+#include "DbDatabase.h"
+
+// Emprise du dessin en coordonnées item (coordonnées dessin, axe Y inversé)
+namespace DwgExtents
+{
+    // Parcourt toutes les entités (getGeomExtents) : rectangle nul en cas d'échec
+    QRectF exactBounds(OdDbDatabase* pDb);
+
+    // Emprise enregistrée dans l'en-tête (EXTMIN/EXTMAX, à défaut les limites
+    // de la présentation), sans parcours : immédiate mais parfois périmée.
+    // Rectangle nul si aucune n'est valide
+    QRectF headerBounds(OdDbDatabase* pDb);
+
+    // Emprise d'une présentation quelconque, active ou non, sans parcours :
+    // espace objet comme headerBounds(), présentation papier d'après son
+    // emprise enregistrée ou, à défaut, sa feuille (limites)
+    QRectF layoutBounds(OdDbDatabase* pDb, const OdDbObjectId& layoutId);
+}
+
+#endif // DWGEXTENTS_H
@@ -0,0 +1,100 @@
+#include "DwgGraphicsView.h"
+#include "DwgTrace.h"
+
+#include <QEasingCurve>
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
+#include <QVariantAnimation>
+
+#include <algorithm>
+#include <cmath>
+
+DwgGraphicsView::DwgGraphicsView(QGraphicsScene* scene, bool scrollingMode, QWidget* parent)
+    : QGraphicsView(scene, parent)
+{
+    m_window.start();
+    setScrollingMode(scrollingMode);
+}
+
+void DwgGraphicsView::setScrollingMode(bool enabled)
+{
+    m_scrollingMode = enabled;
+
+    if (enabled) {
+        // Le contenu est décalé par QWidget::scroll() : seules les bandes
+        // découvertes passent par paint()
+        setViewport(new QWidget());
+        setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+        setOptimizationFlags(QGraphicsView::DontSavePainterState | QGraphicsView::DontAdjustForAntialiasing);
+    } else {
+        // Configuration OpenGL
+        QOpenGLWidget* openGlWidget = new QOpenGLWidget();
+        QSurfaceFormat format;
+        format.setSamples(4);
+        format.setDepthBufferSize(24); // Important pour la 3D
+        format.setStencilBufferSize(8);
+        openGlWidget->setFormat(format);
+
+        setViewport(openGlWidget);
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate); // Important pour OpenGL
+        setOptimizationFlags(QGraphicsView::OptimizationFlags());
+    }
+}
+
+void DwgGraphicsView::paintEvent(QPaintEvent* event)
+{
+    DWG_TRACE_SPAN("frame");
+    QElapsedTimer timer;
+    timer.start();
+    QGraphicsView::paintEvent(event);
+    m_frameMs.append(timer.nsecsElapsed() / 1.0e6);
+}
+
+void DwgGraphicsView::animateTo(const QRectF& sceneRect, int durationMs)
+{
+    if (sceneRect.isEmpty())
+        return;
+    if (!m_zoomAnimation) {
+        m_zoomAnimation = new QVariantAnimation(this);
+        m_zoomAnimation->setEasingCurve(QEasingCurve::InOutCubic);
+    }
+    m_zoomAnimation->stop();
+    m_zoomAnimation->disconnect(this);
+
+    const QRectF from = mapToScene(viewport()->rect()).boundingRect();
+    const QRectF to = sceneRect;
+    if (from.isEmpty()) {
+        fitInView(to, Qt::KeepAspectRatio);
+        return;
+    }
+
+    m_zoomAnimation->setDuration(durationMs);
+    m_zoomAnimation->setStartValue(0.0);
+    m_zoomAnimation->setEndValue(1.0);
+    connect(m_zoomAnimation, &QVariantAnimation::valueChanged, this, [this, from, to](const QVariant& value) {
+        const qreal t = value.toReal();
+        const QPointF center = from.center() + (to.center() - from.center()) * t;
+        const qreal width = from.width() * std::pow(to.width() / from.width(), t);
+        const qreal height = from.height() * std::pow(to.height() / from.height(), t);
+        // fitInView centre lui-même : l'ancre de transformation (souris) n'intervient pas
+        fitInView(QRectF(center.x() - width / 2, center.y() - height / 2, width, height), Qt::KeepAspectRatio);
+    });
+    m_zoomAnimation->start();
+}
+
+DwgFrameStats DwgGraphicsView::takeFrameStats()
+{
+    DwgFrameStats stats;
+    const qint64 windowMs = m_window.restart();
+    stats.frames = m_frameMs.size();
+    if (stats.frames == 0)
+        return stats;
+
+    std::sort(m_frameMs.begin(), m_frameMs.end());
+    stats.framesPerSecond = windowMs > 0 ? stats.frames * 1000.0 / windowMs : 0.0;
+    stats.medianMs = m_frameMs.at(stats.frames / 2);
+    stats.p95Ms = m_frameMs.at(qMin(stats.frames - 1, stats.frames * 95 / 100));
+    stats.maxMs = m_frameMs.last();
+    m_frameMs.clear();
+    return stats;
+}
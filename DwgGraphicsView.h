@@ -0,0 +1,52 @@
+#ifndef DWGGRAPHICSVIEW_H
+#define DWGGRAPHICSVIEW_H
+
+#include <QElapsedTimer>
+#include <QGraphicsView>
+#include <QVector>
+
+class QVariantAnimation;
+
+// Statistiques des images affichées sur une fenêtre de mesure
+struct DwgFrameStats
+{
+    int frames = 0;
+    qreal framesPerSecond = 0.0;
+    qreal medianMs = 0.0;
+    qreal p95Ms = 0.0;
+    qreal maxMs = 0.0;
+};
+
+// Vue de la visionneuse avec deux modes d'affichage :
+// - OpenGL (par défaut) : viewport QOpenGLWidget multiéchantillonné,
+//   toute la vue est redessinée à chaque image ;
+// - défilement : viewport raster en mise à jour minimale ; pendant un
+//   déplacement, Qt fait défiler le contenu déjà affiché et seules les
+//   bandes découvertes sont repeintes.
+// La durée de chaque paintEvent est mesurée pour le suivi des images/s.
+class DwgGraphicsView : public QGraphicsView
+{
+public:
+    DwgGraphicsView(QGraphicsScene* scene, bool scrollingMode, QWidget* parent = nullptr);
+
+    void setScrollingMode(bool enabled);
+    bool scrollingMode() const { return m_scrollingMode; }
+
+    // Statistiques depuis l'appel précédent, puis remise à zéro
+    DwgFrameStats takeFrameStats();
+
+    // Cadre la zone (coordonnées scène) par une animation : centre interpolé
+    // linéairement, taille géométriquement (vitesse de zoom constante)
+    void animateTo(const QRectF& sceneRect, int durationMs = 400);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    bool m_scrollingMode = false;
+    QVariantAnimation* m_zoomAnimation = nullptr;
+    QVector<qreal> m_frameMs;
+    QElapsedTimer m_window;
+};
+
+#endif // DWGGRAPHICSVIEW_H
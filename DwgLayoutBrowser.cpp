@@ -0,0 +1,290 @@
+#include "DwgLayoutBrowser.h"
+#include "DwgDiskCache.h"
+#include "DwgExtents.h"
+#include "DwgMemory.h"
+#include "DwgOffscreenRenderer.h"
+#include "DwgPixelKernels.h"
+#include "DwgThreadScope.h"
+#include "DwgTrace.h"
+
+#include <QDebug>
+#include <QFont>
+#include <QIcon>
+#include <QPixmap>
+#include <QScrollBar>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "DbDictionary.h"
+#include "DbLayout.h"
+
+struct DwgLayoutBrowser::Document
+{
+    OdDbDatabasePtr pDb;
+    QString filePath;
+    // Empreinte pour le cache disque, calculée par la première tâche
+    std::once_flag hashOnce;
+    QByteArray hash;
+    // Lu par DwgGiContext::regenAbort() pendant les rendus
+    std::atomic<bool> abort { false };
+};
+
+namespace {
+
+QString handleOf(const OdDbObjectId& id)
+{
+    const OdString handle = id.getHandle().ascii();
+    return QString::fromWCharArray((const wchar_t*)handle.c_str());
+}
+
+QImage renderThumbnail(OdDbDatabasePtr pDb, const OdDbObjectId& layoutId, const QByteArray& cacheKey,
+                       const std::atomic<bool>* pAbort)
+{
+    DWG_TRACE_SPAN("layoutThumbnail");
+    QImage image = DwgDiskCache::instance().load(cacheKey);
+    if (!image.isNull())
+        return image;
+
+    const QRectF bounds = DwgExtents::layoutBounds(pDb.get(), layoutId);
+    if (bounds.isEmpty())
+        return QImage();
+
+    // Rendu au double de la taille puis réduction 2:1 : traits lissés
+    const int side = 2 * DwgLayoutBrowser::kThumbnailSize;
+    const QSizeF fitted = bounds.size().scaled(side, side, Qt::KeepAspectRatio);
+    const QSize size(qMax(2, qRound(fitted.width())), qMax(2, qRound(fitted.height())));
+    DwgOffscreenRenderer renderer(pDb, layoutId);
+    renderer.setAbortFlag(pAbort);
+    if (!renderer.render(bounds, size, image) || pAbort->load())
+        return QImage();
+
+    image = DwgPixelKernels::downsample2x(image);
+    DwgDiskCache::instance().store(cacheKey, image);
+    return image;
+}
+
+} // namespace
+
+DwgLayoutBrowser::DwgLayoutBrowser(QWidget* parent)
+    : QListWidget(parent)
+{
+    setViewMode(QListView::IconMode);
+    setFlow(QListView::TopToBottom);
+    setWrapping(false);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setUniformItemSizes(true);
+    setSpacing(6);
+    setIconSize(QSize(kThumbnailSize, kThumbnailSize));
+
+    // Les tuiles de la vue gardent la priorité : peu de threads pour les vignettes
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &DwgLayoutBrowser::requestVisible);
+    connect(this, &QListWidget::itemClicked, this, [this](QListWidgetItem* item) {
+        emit layoutActivated(item->data(Qt::UserRole).toString(), item->text());
+    });
+}
+
+DwgLayoutBrowser::~DwgLayoutBrowser()
+{
+    setDatabase(OdDbDatabasePtr());
+}
+
+void DwgLayoutBrowser::setDatabase(OdDbDatabasePtr pDb)
+{
+    waitForIdle();
+    clear();
+    m_layoutIds.clear();
+    m_thumbnails.clear();
+    m_failed.clear();
+    m_inFlight.clear();
+    m_pending.clear();
+    m_document.reset();
+    if (pDb.isNull())
+        return;
+
+    // Onglets dans l'ordre du dessin, espace objet en premier
+    struct Layout
+    {
+        int tabOrder;
+        QString name;
+        OdDbObjectId id;
+    };
+    QVector<Layout> layouts;
+    try {
+        OdDbDictionaryPtr pLayouts = pDb->getLayoutDictionaryId().safeOpenObject();
+        for (OdDbDictionaryIteratorPtr it = pLayouts->newIterator(); !it->done(); it->next()) {
+            OdDbLayoutPtr pLayout = it->objectId().safeOpenObject();
+            layouts.append({ pLayout->getTabOrder(),
+                             QString::fromWCharArray((const wchar_t*)pLayout->getLayoutName().c_str()),
+                             it->objectId() });
+        }
+    } catch (const OdError& e) {
+        qWarning() << "Layout dictionary:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+    }
+    std::sort(layouts.begin(), layouts.end(), [](const Layout& a, const Layout& b) { return a.tabOrder < b.tabOrder; });
+
+    QPixmap placeholder(kThumbnailSize, kThumbnailSize);
+    placeholder.fill(QColor(240, 240, 240));
+    for (const Layout& layout : layouts) {
+        const QString handle = handleOf(layout.id);
+        QListWidgetItem* item = new QListWidgetItem(QIcon(placeholder), layout.name);
+        item->setData(Qt::UserRole, handle);
+        item->setToolTip(layout.name);
+        addItem(item);
+        m_layoutIds.insert(handle, layout.id);
+    }
+
+    m_document = std::make_shared<Document>();
+    m_document->pDb = pDb;
+    m_document->filePath = QString::fromWCharArray((const wchar_t*)pDb->getFilename().c_str());
+    setCurrentLayout(handleOf(pDb->currentLayoutId()));
+}
+
+void DwgLayoutBrowser::setCurrentLayout(const QString& handle)
+{
+    for (int i = 0; i < count(); ++i) {
+        QListWidgetItem* listItem = item(i);
+        QFont font = listItem->font();
+        font.setBold(listItem->data(Qt::UserRole).toString() == handle);
+        listItem->setFont(font);
+    }
+    if (QListWidgetItem* current = itemFor(handle))
+        setCurrentItem(current);
+
+    // Les vignettes sont rendues pendant que les threads de tuiles lisent la base
+    if (m_document && !m_multiThreaded)
+        m_multiThreaded.reset(new DwgMultiThreadedMode(m_document->pDb.get()));
+
+    // Reprise des rendus, une fois la mise en page à jour
+    QTimer::singleShot(0, this, &DwgLayoutBrowser::requestVisible);
+}
+
+void DwgLayoutBrowser::waitForIdle()
+{
+    if (!m_document)
+        return;
+
+    m_pending.clear();
+    m_document->abort = true;
+    m_pool.waitForDone();
+    m_document->abort = false;
+    // Plus aucun rendu de vignette : la base peut repasser en monothread
+    m_multiThreaded.reset();
+    // Les résultats encore en route ne comptent plus comme rendus en cours
+    m_inFlight.clear();
+    ++m_epoch;
+}
+
+OdDbObjectId DwgLayoutBrowser::layoutId(const QString& handle) const
+{
+    return m_layoutIds.value(handle);
+}
+
+QImage DwgLayoutBrowser::thumbnail(const QString& handle) const
+{
+    return m_thumbnails.value(handle);
+}
+
+void DwgLayoutBrowser::resizeEvent(QResizeEvent* event)
+{
+    QListWidget::resizeEvent(event);
+    QTimer::singleShot(0, this, &DwgLayoutBrowser::requestVisible);
+}
+
+void DwgLayoutBrowser::showEvent(QShowEvent* event)
+{
+    QListWidget::showEvent(event);
+    QTimer::singleShot(0, this, &DwgLayoutBrowser::requestVisible);
+}
+
+void DwgLayoutBrowser::requestVisible()
+{
+    // Panneau fermé : aucune vignette n'est rendue
+    if (!m_document || !isVisible())
+        return;
+
+    // Zone visible et une page d'avance dans le sens du défilement
+    const QRect area = viewport()->rect().adjusted(0, 0, 0, viewport()->height());
+    m_pending.clear();
+    for (int i = 0; i < count(); ++i) {
+        QListWidgetItem* listItem = item(i);
+        const QString handle = listItem->data(Qt::UserRole).toString();
+        if (m_thumbnails.contains(handle) || m_failed.contains(handle) || m_inFlight.contains(handle))
+            continue;
+        if (visualItemRect(listItem).intersects(area))
+            m_pending.append(handle);
+    }
+    startNext();
+}
+
+void DwgLayoutBrowser::startNext()
+{
+    // Une tâche par thread au plus : la file reste de notre côté et suit le défilement
+    while (!m_pending.isEmpty() && m_inFlight.size() < m_pool.maxThreadCount()) {
+        const QString handle = m_pending.takeFirst();
+        const OdDbObjectId layoutId = m_layoutIds.value(handle);
+        m_inFlight.insert(handle);
+
+        std::shared_ptr<Document> document = m_document;
+        const std::weak_ptr<Document> weakDocument = m_document;
+        const quint64 epoch = m_epoch;
+        m_pool.start([this, document, weakDocument, epoch, handle, layoutId]() {
+            DwgThreadScope threadScope;
+            DwgMemory::DocumentScope memoryScope(DwgMemory::documentFor(document->pDb.get()));
+
+            std::call_once(document->hashOnce, [&document]() {
+                if (DwgDiskCache::instance().isEnabled() && !document->filePath.isEmpty())
+                    document->hash = DwgDiskCache::fileHash(document->filePath);
+            });
+            const QByteArray cacheKey = document->hash.isEmpty()
+                ? QByteArray()
+                : DwgDiskCache::makeKey(document->hash, handle, QString("thumbnail %1").arg(kThumbnailSize));
+
+            const QImage image = renderThumbnail(document->pDb, layoutId, cacheKey, &document->abort);
+            const bool aborted = document->abort;
+
+            // Référence faible : un résultat en route ne retient pas la base
+            QMetaObject::invokeMethod(this, [this, weakDocument, epoch, handle, image, aborted]() {
+                const std::shared_ptr<Document> current = weakDocument.lock();
+                if (current && current == m_document)
+                    onThumbnailReady(epoch, handle, image, aborted);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void DwgLayoutBrowser::onThumbnailReady(quint64 epoch, const QString& handle, const QImage& image, bool aborted)
+{
+    if (epoch == m_epoch)
+        m_inFlight.remove(handle);
+
+    QListWidgetItem* listItem = itemFor(handle);
+    if (!image.isNull()) {
+        m_thumbnails.insert(handle, image);
+        if (listItem)
+            listItem->setIcon(QIcon(QPixmap::fromImage(image)));
+    } else if (!aborted) {
+        // Emprise invalide ou échec du rendu : pas de nouvel essai pour ce document
+        m_failed.insert(handle);
+        if (listItem)
+            listItem->setToolTip(listItem->text() + " (vignette indisponible)");
+    }
+
+    if (epoch == m_epoch)
+        startNext();
+}
+
+QListWidgetItem* DwgLayoutBrowser::itemFor(const QString& handle) const
+{
+    for (int i = 0; i < count(); ++i) {
+        if (item(i)->data(Qt::UserRole).toString() == handle)
+            return item(i);
+    }
+    return nullptr;
+}
@@ -0,0 +1,84 @@
+#include "OdaCommon.h"
+
+#ifndef DWGLAYOUTBROWSER_H
+#define DWGLAYOUTBROWSER_H
+
+#include <QHash>
+#include <QImage>
+#include <QListWidget>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <memory>
+
+#include "DbDatabase.h"
+
+class DwgMultiThreadedMode;
+
+// Panneau des présentations du document (espace objet et feuilles), avec
+// une vignette par présentation. Les vignettes ne sont rendues que pour les
+// éléments visibles (et une page d'avance), au fil du défilement, sur un
+// pool de threads borné : chaque rendu a son device bitmap sur la base
+// partagée et ne touche pas à la présentation active. Elles sont gardées
+// pour le document courant et dans le cache disque.
+// Un clic émet layoutActivated() ; avant de changer la présentation active
+// de la base, l'appelant arrête les rendus de vignettes (waitForIdle()).
+class DwgLayoutBrowser : public QListWidget
+{
+    Q_OBJECT
+
+public:
+    // Côté le plus long d'une vignette, en pixels
+    static const int kThumbnailSize = 160;
+
+    explicit DwgLayoutBrowser(QWidget* parent = nullptr);
+    ~DwgLayoutBrowser();
+
+    // Lit les présentations dans le thread GUI, avant tout rendu concurrent ;
+    // base nulle : vide le panneau et attend la fin des rendus
+    void setDatabase(OdDbDatabasePtr pDb);
+
+    // Présentation mise en évidence ; les rendus reprennent après waitForIdle().
+    // Comme waitForIdle(), à appeler quand aucun thread de tuiles ne tourne
+    // (le mode multithread de la base peut changer)
+    void setCurrentLayout(const QString& handle);
+
+    // Abandonne les vignettes en attente, attend celles en cours et libère
+    // le mode multithread de la base
+    void waitForIdle();
+
+    OdDbObjectId layoutId(const QString& handle) const;
+    // Vignette déjà rendue, nulle sinon
+    QImage thumbnail(const QString& handle) const;
+
+signals:
+    void layoutActivated(const QString& handle, const QString& name);
+
+protected:
+    void resizeEvent(QResizeEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+
+private:
+    // État partagé avec les tâches du pool, propre à un document
+    struct Document;
+
+    void requestVisible();
+    void startNext();
+    void onThumbnailReady(quint64 epoch, const QString& handle, const QImage& image, bool aborted);
+    QListWidgetItem* itemFor(const QString& handle) const;
+
+    QThreadPool m_pool;
+    std::shared_ptr<Document> m_document;
+    std::unique_ptr<DwgMultiThreadedMode> m_multiThreaded;
+    QHash<QString, OdDbObjectId> m_layoutIds;       // Handle -> présentation
+
+    // Document courant
+    QHash<QString, QImage> m_thumbnails;
+    QSet<QString> m_failed;
+    QSet<QString> m_inFlight;
+    QStringList m_pending;          // Éléments visibles, de haut en bas
+    quint64 m_epoch = 0;            // Incrémenté par waitForIdle()
+};
+
+#endif // DWGLAYOUTBROWSER_H
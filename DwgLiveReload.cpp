@@ -0,0 +1,176 @@
+#include "DwgLiveReload.h"
+#include "DwgMemory.h"
+#include "DwgTrace.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QPointer>
+#include <QThread>
+
+// Délai sans nouvelle modification avant de relire : un enregistrement
+// écrit le fichier en plusieurs fois (ou le remplace par renommage)
+static const int kSettleMs = 1000;
+
+// Au-delà, la modification n'a rien de local : tout est rendu de nouveau
+static const int kMaxChangedRegions = 4096;
+
+DwgLiveReload::DwgLiveReload(QObject* parent)
+    : QObject(parent)
+    , m_loader(new DwgLoader(this))
+{
+    // Le poste CAO peut réécrire le fichier pendant la relecture : une
+    // projection tronquée ferait tomber le processus
+    m_loader->setMappedInput(false);
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(kSettleMs);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &DwgLiveReload::onFileChanged);
+    connect(&m_settleTimer, &QTimer::timeout, this, &DwgLiveReload::onSettled);
+    connect(m_loader, &DwgLoader::loaded, this, &DwgLiveReload::onLoaded);
+    connect(m_loader, &DwgLoader::failed, this, [this](const QString& filePath, const QString&, const QString& message) {
+        emit reloadFailed(filePath, message);
+    });
+}
+
+DwgLiveReload::~DwgLiveReload()
+{
+    setFile(QString());
+}
+
+void DwgLiveReload::setFile(const QString& filePath)
+{
+    if (!m_watcher.files().isEmpty())
+        m_watcher.removePaths(m_watcher.files());
+    m_settleTimer.stop();
+    m_loader->cancel();
+    stopCompare();
+    m_previous.reset();
+    m_layoutHandle.clear();
+
+    m_filePath = filePath;
+    if (!m_filePath.isEmpty())
+        m_watcher.addPath(m_filePath);
+}
+
+void DwgLiveReload::onFileChanged(const QString& filePath)
+{
+    if (filePath != m_filePath)
+        return;
+    // Chaque écriture relance l'attente : relu une fois l'enregistrement terminé
+    m_settleTimer.start();
+}
+
+void DwgLiveReload::onSettled()
+{
+    // Enregistrement par fichier temporaire puis renommage : le watcher a
+    // perdu le fichier, il est surveillé de nouveau une fois remplacé
+    if (!QFileInfo::exists(m_filePath)) {
+        m_settleTimer.start();
+        return;
+    }
+    if (!m_watcher.files().contains(m_filePath))
+        m_watcher.addPath(m_filePath);
+    emit fileModified(m_filePath);
+}
+
+void DwgLiveReload::reload(const DwgSpatialIndexPtr& previous, const QString& layoutHandle)
+{
+    if (m_filePath.isEmpty())
+        return;
+
+    // Une lecture ou comparaison en cours porte sur une version déjà dépassée
+    stopCompare();
+    m_previous = previous;
+    m_layoutHandle = layoutHandle;
+    m_loader->load(m_filePath);
+}
+
+void DwgLiveReload::onLoaded(const QString& filePath, OdDbDatabasePtr pDb)
+{
+    if (filePath != m_filePath) {
+        DwgLoader::releaseInBackground(pDb);
+        return;
+    }
+
+    const quint64 generation = ++m_generation;
+    m_abort = std::make_shared<std::atomic<bool>>(false);
+    std::shared_ptr<std::atomic<bool>> abort = m_abort;
+    const DwgSpatialIndexPtr previous = m_previous;
+    const QString layoutHandle = m_layoutHandle;
+    QPointer<DwgLiveReload> self(this);
+
+    // La nouvelle base n'est encore partagée avec personne : elle est lue ici sans verrou
+    m_compareThread = QThread::create([=]() mutable {
+        DWG_TRACE_SPAN("reloadCompare");
+        DwgMemory::DocumentScope memoryScope(DwgMemory::documentFor(pDb.get()));
+
+        // Même présentation qu'avant l'enregistrement, si elle existe encore
+        if (!layoutHandle.isEmpty()) {
+            try {
+                const std::wstring handle = layoutHandle.toStdWString();
+                const OdDbObjectId layoutId = pDb->getOdDbObjectId(OdDbHandle((const OdChar*)handle.c_str()));
+                if (!layoutId.isNull() && layoutId != pDb->currentLayoutId())
+                    pDb->setCurrentLayout(layoutId);
+            } catch (const OdError& e) {
+                qWarning() << "Reload layout:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+            }
+        }
+
+        DwgSpatialIndexBuilder builder(pDb.get());
+        while (builder.step(4096)) {
+            if (*abort)
+                break;
+        }
+        DwgSpatialIndexPtr index;
+        if (!*abort)
+            index = builder.finish();
+
+        // Un index incomplet ignore les entités sans emprise (droites
+        // infinies...) : leurs modifications ne se localisent pas. Un
+        // calque, un style ou un bloc modifié touche toutes ses utilisations
+        QVector<QRectF> regions;
+        bool allChanged = !previous || !index || !previous->isComplete() || !index->isComplete()
+                          || previous->definitionsHash() != index->definitionsHash();
+        if (!allChanged) {
+            regions = DwgSpatialIndex::changedRegions(*previous, *index);
+            allChanged = regions.size() > kMaxChangedRegions;
+            if (allChanged)
+                regions.clear();
+        }
+        // -1 : tout est à rendre
+        DwgTrace::counter("reloadChangedRegions", allChanged ? -1 : regions.size());
+
+        QMetaObject::invokeMethod(self, [self, generation, abort, filePath, pDb, index, regions, allChanged]() mutable {
+            if (!self || *abort || generation != self->m_generation) {
+                DwgLoader::releaseInBackground(pDb);
+                return;
+            }
+            self->m_abort.reset();
+            emit self->reloaded(filePath, pDb, index, regions, allChanged);
+        }, Qt::QueuedConnection);
+        // Seule la référence transmise au thread GUI reste
+        pDb.release();
+    });
+    m_compareThread->setObjectName("DwgLiveReload compare");
+    QThread* thread = m_compareThread;
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        if (m_compareThread != thread)
+            return;
+        m_compareThread->deleteLater();
+        m_compareThread = nullptr;
+    });
+    m_compareThread->start(QThread::LowPriority);
+}
+
+void DwgLiveReload::stopCompare()
+{
+    ++m_generation;
+    if (m_abort)
+        *m_abort = true;
+    m_abort.reset();
+    if (!m_compareThread)
+        return;
+    // La base du thread est libérée par son résultat, jeté car dépassé
+    m_compareThread->wait();
+    delete m_compareThread;
+    m_compareThread = nullptr;
+}
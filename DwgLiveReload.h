@@ -0,0 +1,81 @@
+#include "OdaCommon.h"
+
+#ifndef DWGLIVERELOAD_H
+#define DWGLIVERELOAD_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QRectF>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "DbDatabase.h"
+
+#include "DwgLoader.h"
+#include "DwgSpatialIndex.h"
+
+class QThread;
+
+// Rechargement du fichier ouvert quand il change sur disque (enregistrement
+// depuis un poste CAO). La nouvelle version est lue dans une nouvelle base
+// par DwgLoader, puis un thread rétablit la présentation affichée, construit
+// son index spatial et le compare à celui de la base affichée : seules les
+// zones modifiées sont à rendre de nouveau. Rien n'est touché côté
+// affichage avant reloaded(), où l'appelant échange les bases d'un coup.
+class DwgLiveReload : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DwgLiveReload(QObject* parent = nullptr);
+    ~DwgLiveReload();
+
+    // Fichier surveillé ; vide : surveillance arrêtée, rechargement en cours abandonné
+    void setFile(const QString& filePath);
+    QString file() const { return m_filePath; }
+
+    void setPartialLoad(bool partial) { m_loader->setPartialLoad(partial); }
+
+    // Relit le fichier et compare la nouvelle version à l'index de la base
+    // affichée (nul : tout est à rendre). layoutHandle est la présentation
+    // à rendre active dans la nouvelle base si elle y existe encore
+    void reload(const DwgSpatialIndexPtr& previous, const QString& layoutHandle);
+
+signals:
+    // Fichier modifié puis stable depuis kSettleMs : l'appelant répond par reload()
+    void fileModified(const QString& filePath);
+
+    // Nouvelle base prête, à la charge du récepteur ; changedRegions en
+    // coordonnées item, ignoré si allChanged
+    void reloaded(const QString& filePath, OdDbDatabasePtr pDb, const DwgSpatialIndexPtr& index,
+                  const QVector<QRectF>& changedRegions, bool allChanged);
+    void reloadFailed(const QString& filePath, const QString& message);
+
+private slots:
+    void onFileChanged(const QString& filePath);
+    void onSettled();
+    void onLoaded(const QString& filePath, OdDbDatabasePtr pDb);
+
+private:
+    void stopCompare();
+
+    QString m_filePath;
+    QFileSystemWatcher m_watcher;
+    QTimer m_settleTimer;
+    DwgLoader* m_loader;
+
+    // Référence de la comparaison, fixée par reload()
+    DwgSpatialIndexPtr m_previous;
+    QString m_layoutHandle;
+
+    // Comparaison en cours ; les résultats d'une génération dépassée sont jetés
+    QThread* m_compareThread = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_abort;
+    quint64 m_generation = 0;
+};
+
+#endif // DWGLIVERELOAD_H
@@ -0,0 +1,214 @@
+#include "DwgLoader.h"
+#include "DwgTrace.h"
+#include "MyServices.h"
+
+#include <QDebug>
+#include <QThreadPool>
+#include <QtEndian>
+
+#include "ThumbnailImage.h"
+
+namespace {
+
+// Relaie l'avancement de MyProgressMeter vers le loader (thread GUI)
+class LoadProgressListener : public MyProgressListener
+{
+public:
+    LoadProgressListener(DwgLoader* pLoader, std::shared_ptr<std::atomic<bool>> pCancel)
+        : m_pLoader(pLoader)
+        , m_pCancel(std::move(pCancel))
+    {
+    }
+
+    void onProgress(const QString& stage, int percent) override
+    {
+        DwgLoader* pLoader = m_pLoader;
+        std::shared_ptr<std::atomic<bool>> pCancel = m_pCancel;
+        QMetaObject::invokeMethod(pLoader, [pLoader, pCancel, stage, percent]() {
+            if (!*pCancel)
+                emit pLoader->progress(stage, percent);
+        }, Qt::QueuedConnection);
+    }
+
+    bool isCancelled() const override
+    {
+        return *m_pCancel;
+    }
+
+private:
+    DwgLoader* m_pLoader;
+    std::shared_ptr<std::atomic<bool>> m_pCancel;
+};
+
+// Les aperçus BMP sont stockés sans en-tête de fichier (BITMAPFILEHEADER) :
+// on le reconstruit pour QImage
+QImage imageFromDib(const OdBinaryData& dib)
+{
+    const int size = int(dib.size());
+    if (size < 40)
+        return QImage();
+
+    const uchar* data = dib.asArrayPtr();
+    const quint32 headerSize = qFromLittleEndian<quint32>(data);
+    const quint16 bitCount = qFromLittleEndian<quint16>(data + 14);
+    const quint32 colorsUsed = qFromLittleEndian<quint32>(data + 32);
+    const quint32 paletteSize = 4 * (colorsUsed ? colorsUsed : (bitCount <= 8 ? 1u << bitCount : 0u));
+
+    QByteArray file(14, '\0');
+    file[0] = 'B';
+    file[1] = 'M';
+    qToLittleEndian<quint32>(quint32(14 + size), file.data() + 2);
+    qToLittleEndian<quint32>(quint32(14 + headerSize + paletteSize), file.data() + 10);
+    file.append(reinterpret_cast<const char*>(data), size);
+
+    QImage image;
+    image.loadFromData(file, "BMP");
+    return image;
+}
+
+} // namespace
+
+DwgLoader::DwgLoader(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<OdDbDatabasePtr>();
+}
+
+DwgLoader::~DwgLoader()
+{
+    cancel();
+    waitForBackgroundWork();
+}
+
+QThreadPool* DwgLoader::pool()
+{
+    // Pool dédié : ne concurrence pas QThreadPool::globalInstance()
+    static QThreadPool* s_pool = [] {
+        QThreadPool* p = new QThreadPool();
+        p->setMaxThreadCount(2);
+        return p;
+    }();
+    return s_pool;
+}
+
+void DwgLoader::load(const QString& filePath)
+{
+    cancel();
+
+    const quint64 generation = ++m_generation;
+    m_pCancel = std::make_shared<std::atomic<bool>>(false);
+    std::shared_ptr<std::atomic<bool>> pCancel = m_pCancel;
+    const bool partialLoad = m_partialLoad;
+    const bool mappedInput = m_mappedInput;
+
+    pool()->start([this, filePath, generation, pCancel, partialLoad, mappedInput]() {
+        LoadProgressListener listener(this, pCancel);
+        MyServices::setThreadProgressListener(&listener);
+        MyServices::setThreadMappedFileInput(mappedInput);
+
+        OdDbDatabasePtr pDb;
+        QString errorTitle;
+        QString errorMessage;
+        try
+        {
+            if (!g_pServices) throw std::runtime_error("Services Teigha non initialisés.");
+
+            // Aperçu d'abord : affiché en quelques millisecondes, bien avant la base
+            const QImage preview = readPreview(filePath);
+            if (!preview.isNull()) {
+                QMetaObject::invokeMethod(this, [this, filePath, generation, pCancel, preview]() {
+                    if (generation == m_generation && !*pCancel)
+                        emit previewReady(filePath, preview);
+                }, Qt::QueuedConnection);
+            }
+
+            DWG_TRACE_SPAN("readFile");
+            // Cast explicite vers wchar_t* pour être sûr
+            pDb = g_pServices->readFile((const wchar_t*)filePath.toStdWString().c_str(), false, partialLoad);
+
+            if (pDb.isNull()) throw std::runtime_error("Impossible de lire le fichier DWG.");
+        }
+        catch (const OdError& e)
+        {
+            if (e.code() != eUserBreak) {
+                errorTitle = "Erreur Teigha";
+                errorMessage = "Erreur de chargement :\n" + QString::fromWCharArray((const wchar_t*)e.description().c_str());
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            errorTitle = "Erreur";
+            errorMessage = QString("Erreur système : %1").arg(ex.what());
+        }
+
+        MyServices::setThreadProgressListener(nullptr);
+        MyServices::setThreadMappedFileInput(true);
+
+        QMetaObject::invokeMethod(this, [this, filePath, generation, pCancel, pDb, errorTitle, errorMessage]() mutable {
+            const bool current = generation == m_generation && !*pCancel;
+            if (current)
+                m_pCancel.reset();
+
+            if (!pDb.isNull()) {
+                if (current)
+                    emit loaded(filePath, pDb);
+                else
+                    releaseInBackground(pDb);
+            } else if (current && !errorMessage.isEmpty()) {
+                emit failed(filePath, errorTitle, errorMessage);
+            } else if (generation == m_generation) {
+                emit cancelled(filePath);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void DwgLoader::cancel()
+{
+    if (m_pCancel) {
+        *m_pCancel = true;
+        m_pCancel.reset();
+    }
+}
+
+void DwgLoader::releaseInBackground(OdDbDatabasePtr& pDb)
+{
+    if (pDb.isNull())
+        return;
+
+    // Transfert de la référence au thread de fond : l'appelant n'en garde aucune
+    OdDbDatabase* pRaw = pDb.detach();
+    pool()->start([pRaw]() {
+        DWG_TRACE_SPAN("closeDatabase");
+        OdDbDatabasePtr pReleased(pRaw, kOdRxObjAttach);
+        MyServices::closeDatabase(pReleased);
+    });
+}
+
+void DwgLoader::waitForBackgroundWork()
+{
+    pool()->waitForDone();
+}
+
+QImage DwgLoader::readPreview(const QString& filePath)
+{
+    if (!g_pServices)
+        return QImage();
+
+    DWG_TRACE_SPAN("readPreview");
+    try {
+        OdStreamBufPtr pStream = g_pServices->createFile((const wchar_t*)filePath.toStdWString().c_str());
+        OdThumbnailImage preview;
+        odDbGetPreviewBitmap(pStream, &preview);
+
+        QImage image;
+        if (preview.hasPng())
+            image.loadFromData(preview.png.asArrayPtr(), int(preview.png.size()), "PNG");
+        if (image.isNull() && preview.hasBmp())
+            image = imageFromDib(preview.bmp);
+        return image;
+    } catch (const OdError& e) {
+        qDebug() << "No DWG preview:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+    }
+    return QImage();
+}
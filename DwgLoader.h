@@ -0,0 +1,72 @@
+#include "OdaCommon.h"
+
+#ifndef DWGLOADER_H
+#define DWGLOADER_H
+
+#include <QImage>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+#include "DbDatabase.h"
+
+Q_DECLARE_METATYPE(OdDbDatabasePtr)
+
+class QThreadPool;
+
+// Lecture des fichiers DWG hors du thread GUI, avec avancement et annulation.
+// Les signaux sont émis dans le thread du loader.
+class DwgLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DwgLoader(QObject* parent = nullptr);
+    ~DwgLoader();
+
+    // Lance la lecture en arrière-plan ; une lecture en cours est annulée
+    void load(const QString& filePath);
+    void cancel();
+    bool isLoading() const { return m_pCancel != nullptr; }
+
+    // Ouverture rapide : chargement partiel, les objets sont lus à la demande
+    // quand le rendu les atteint (le fichier reste ouvert tant que la base vit)
+    void setPartialLoad(bool partial) { m_partialLoad = partial; }
+    bool partialLoad() const { return m_partialLoad; }
+
+    // Faux : lecture tamponnée, sans projection mémoire, pour un fichier
+    // qui peut encore être réécrit sur place pendant la lecture
+    void setMappedInput(bool mapped) { m_mappedInput = mapped; }
+
+    // Libère une base en arrière-plan : la fermeture d'un gros plan peut
+    // prendre plusieurs secondes et ne doit pas bloquer l'ouverture suivante.
+    // Le pointeur de l'appelant est remis à zéro.
+    static void releaseInBackground(OdDbDatabasePtr& pDb);
+
+    // Attend la fin des lectures et libérations en cours (avant odUninitialize)
+    static void waitForBackgroundWork();
+
+    // Aperçu enregistré dans le fichier (PNG ou BMP), lu sans charger la base ;
+    // image nulle si le fichier n'en contient pas
+    static QImage readPreview(const QString& filePath);
+
+signals:
+    void progress(const QString& stage, int percent);
+    // Émis avant loaded() quand le fichier contient un aperçu
+    void previewReady(const QString& filePath, const QImage& image);
+    void loaded(const QString& filePath, OdDbDatabasePtr pDb);
+    void failed(const QString& filePath, const QString& title, const QString& message);
+    void cancelled(const QString& filePath);
+
+private:
+    static QThreadPool* pool();
+
+    bool m_partialLoad = false;
+    bool m_mappedInput = true;
+    quint64 m_generation = 0;
+    std::shared_ptr<std::atomic<bool>> m_pCancel;
+};
+
+#endif // DWGLOADER_H
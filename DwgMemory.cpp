@@ -0,0 +1,391 @@
+#include "DwgMemory.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifdef DWG_POOLED_ALLOC
+#include "OdaCommon.h"
+#include "OdAlloc.h"
+#endif
+
+// odrxAlloc peut être appelé avant main() (objets statiques de Teigha) :
+// tout l'état ci-dessous est initialisé statiquement, sans constructeur dynamique
+
+namespace {
+
+const int kClassSizes[] = { 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+                            320, 384, 448, 512, 640, 768, 896, 1024 };
+const int kClassCount = int(sizeof(kClassSizes) / sizeof(kClassSizes[0]));
+const size_t kMaxPooledSize = 1024;
+const size_t kPageSize = 64 * 1024;
+const int kMaxArenas = 64;
+const quint16 kSystemClass = 0xffff;
+
+// Précède chaque bloc ; 16 octets pour garder l'alignement de malloc
+struct BlockHeader
+{
+    quint64 size;           // Taille demandée
+    quint32 document;
+    quint16 sizeClass;      // kSystemClass : tas système
+    quint16 reserved;
+};
+static_assert(sizeof(BlockHeader) == 16, "BlockHeader must stay 16 bytes");
+
+// Sections critiques de quelques instructions : pas de mutex système
+class SpinLock
+{
+public:
+    void lock()
+    {
+        while (m_flag.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    void unlock() { m_flag.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+};
+
+struct Pool
+{
+    SpinLock lock;
+    void* freeList = nullptr;       // Emplacements libérés, chaînés par leur premier mot
+    char* bump = nullptr;           // Reste de la page courante
+    char* bumpEnd = nullptr;
+    void* pages = nullptr;          // Pages chaînées par leurs 16 premiers octets
+    std::atomic<quint64> live { 0 };
+    std::atomic<quint64> allocations { 0 };
+};
+
+enum ArenaState { kFree, kOpen, kClosed, kBusy };
+
+struct Arena
+{
+    std::atomic<int> state { kFree };
+    std::atomic<qint64> current { 0 };
+    std::atomic<qint64> peak { 0 };
+    std::atomic<qint64> reserved { 0 };
+    std::atomic<quint64> allocations { 0 };
+    std::atomic<quint64> frees { 0 };
+    std::atomic<quint64> liveBlocks { 0 };
+    std::atomic<quint64> systemLive { 0 };
+    std::atomic<quint64> systemAllocations { 0 };
+    Pool pools[kClassCount];
+    char name[64] = {};
+};
+
+// Arène 0 : allocations hors de toute portée de document, jamais fermée
+Arena s_arenas[kMaxArenas];
+std::atomic<bool> s_pooled { true };
+thread_local int t_document = 0;
+
+int classFor(size_t size)
+{
+    if (size <= 128)
+        return size == 0 ? 0 : int((size - 1) >> 4);
+    int sizeClass = 8;
+    while (size_t(kClassSizes[sizeClass]) < size)
+        ++sizeClass;
+    return sizeClass;
+}
+
+void account(Arena& arena, qint64 delta)
+{
+    const qint64 current = arena.current.fetch_add(delta, std::memory_order_relaxed) + delta;
+    qint64 peak = arena.peak.load(std::memory_order_relaxed);
+    while (current > peak && !arena.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+void* takeSlot(Arena& arena, int sizeClass)
+{
+    Pool& pool = arena.pools[sizeClass];
+    const size_t slotSize = sizeof(BlockHeader) + size_t(kClassSizes[sizeClass]);
+
+    pool.lock.lock();
+    void* slot = pool.freeList;
+    if (slot) {
+        pool.freeList = *static_cast<void**>(slot);
+    } else {
+        if (!pool.bump || pool.bump + slotSize > pool.bumpEnd) {
+            char* page = static_cast<char*>(std::malloc(kPageSize));
+            if (!page) {
+                pool.lock.unlock();
+                return nullptr;
+            }
+            *reinterpret_cast<void**>(page) = pool.pages;
+            pool.pages = page;
+            pool.bump = page + 16;
+            pool.bumpEnd = page + kPageSize;
+            arena.reserved.fetch_add(qint64(kPageSize), std::memory_order_relaxed);
+        }
+        slot = pool.bump;
+        pool.bump += slotSize;
+    }
+    pool.lock.unlock();
+
+    pool.live.fetch_add(1, std::memory_order_relaxed);
+    pool.allocations.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+// Document fermé et vide : toutes ses pages d'un coup, puis l'arène redevient libre
+void tryReleaseArena(Arena& arena)
+{
+    int expected = kClosed;
+    if (!arena.state.compare_exchange_strong(expected, kBusy))
+        return;
+
+    for (Pool& pool : arena.pools) {
+        pool.lock.lock();
+        void* page = pool.pages;
+        while (page) {
+            void* next = *static_cast<void**>(page);
+            std::free(page);
+            page = next;
+        }
+        pool.pages = nullptr;
+        pool.freeList = nullptr;
+        pool.bump = pool.bumpEnd = nullptr;
+        pool.lock.unlock();
+    }
+    arena.reserved = 0;
+    arena.state = kFree;
+}
+
+void* allocate(size_t size)
+{
+    int document = t_document;
+    if (document != 0 && s_arenas[document].state.load(std::memory_order_acquire) != kOpen)
+        document = 0;
+    Arena& arena = s_arenas[document];
+
+    const bool pooled = size <= kMaxPooledSize && s_pooled.load(std::memory_order_relaxed);
+    const int sizeClass = pooled ? classFor(size) : -1;
+    BlockHeader* header = static_cast<BlockHeader*>(pooled ? takeSlot(arena, sizeClass)
+                                                           : std::malloc(sizeof(BlockHeader) + size));
+    if (!header)
+        return nullptr;
+
+    header->size = size;
+    header->document = quint32(document);
+    header->sizeClass = pooled ? quint16(sizeClass) : kSystemClass;
+    header->reserved = 0;
+    if (!pooled) {
+        arena.systemLive.fetch_add(1, std::memory_order_relaxed);
+        arena.systemAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    account(arena, qint64(size));
+    arena.allocations.fetch_add(1, std::memory_order_relaxed);
+    arena.liveBlocks.fetch_add(1, std::memory_order_relaxed);
+    return header + 1;
+}
+
+void release(void* block)
+{
+    if (!block)
+        return;
+
+    BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+    Arena& arena = s_arenas[header->document];
+    account(arena, -qint64(header->size));
+    arena.frees.fetch_add(1, std::memory_order_relaxed);
+
+    if (header->sizeClass == kSystemClass) {
+        arena.systemLive.fetch_sub(1, std::memory_order_relaxed);
+        std::free(header);
+    } else {
+        Pool& pool = arena.pools[header->sizeClass];
+        pool.live.fetch_sub(1, std::memory_order_relaxed);
+        pool.lock.lock();
+        *reinterpret_cast<void**>(header) = pool.freeList;
+        pool.freeList = header;
+        pool.lock.unlock();
+    }
+
+    if (arena.liveBlocks.fetch_sub(1, std::memory_order_acq_rel) == 1
+        && arena.state.load(std::memory_order_acquire) == kClosed)
+        tryReleaseArena(arena);
+}
+
+void* reallocate(void* block, size_t size)
+{
+    if (!block)
+        return allocate(size);
+
+    BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+    // Reste dans son emplacement tant qu'il y tient
+    if (header->sizeClass != kSystemClass && size <= size_t(kClassSizes[header->sizeClass])) {
+        account(s_arenas[header->document], qint64(size) - qint64(header->size));
+        header->size = size;
+        return block;
+    }
+
+    void* moved = allocate(size);
+    if (moved) {
+        std::memcpy(moved, block, size_t(std::min<quint64>(header->size, size)));
+        release(block);
+    }
+    return moved;
+}
+
+QMutex& databaseMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QHash<const void*, int>& databases()
+{
+    static QHash<const void*, int> map;
+    return map;
+}
+
+} // namespace
+
+#ifdef DWG_POOLED_ALLOC
+// Remplace TD_Alloc : tout ce que Teigha alloue passe par les arènes
+extern "C" {
+
+ALLOCDLL_EXPORT void* odrxAlloc(size_t nBytes)
+{
+    return allocate(nBytes);
+}
+
+ALLOCDLL_EXPORT void* odrxRealloc(void* pMemBlock, size_t newSize, size_t /*oldSize*/)
+{
+    return reallocate(pMemBlock, newSize);
+}
+
+ALLOCDLL_EXPORT void odrxFree(void* pMemBlock)
+{
+    release(pMemBlock);
+}
+
+} // extern "C"
+#endif
+
+namespace DwgMemory
+{
+
+void setPooled(bool pooled)
+{
+    s_pooled = pooled;
+}
+
+bool isPooled()
+{
+    return s_pooled;
+}
+
+int createDocument(const QString& name)
+{
+    for (int i = 1; i < kMaxArenas; ++i) {
+        Arena& arena = s_arenas[i];
+        int expected = kFree;
+        if (!arena.state.compare_exchange_strong(expected, kBusy))
+            continue;
+
+        arena.current = 0;
+        arena.peak = 0;
+        arena.allocations = 0;
+        arena.frees = 0;
+        arena.systemAllocations = 0;
+        for (Pool& pool : arena.pools)
+            pool.allocations = 0;
+        const QByteArray utf8 = name.toUtf8().left(int(sizeof(arena.name)) - 1);
+        std::memset(arena.name, 0, sizeof(arena.name));
+        std::memcpy(arena.name, utf8.constData(), size_t(utf8.size()));
+        arena.state = kOpen;
+        return i;
+    }
+    return 0;
+}
+
+void closeDocument(int document)
+{
+    if (document <= 0 || document >= kMaxArenas)
+        return;
+
+    Arena& arena = s_arenas[document];
+    int expected = kOpen;
+    if (arena.state.compare_exchange_strong(expected, kClosed) && arena.liveBlocks == 0)
+        tryReleaseArena(arena);
+}
+
+void attach(const void* pDb, int document)
+{
+    QMutexLocker lock(&databaseMutex());
+    databases().insert(pDb, document);
+}
+
+void detach(const void* pDb)
+{
+    QMutexLocker lock(&databaseMutex());
+    databases().remove(pDb);
+}
+
+int documentFor(const void* pDb)
+{
+    QMutexLocker lock(&databaseMutex());
+    return databases().value(pDb, 0);
+}
+
+DwgMemoryStats stats(int document)
+{
+    DwgMemoryStats stats;
+    if (document < 0 || document >= kMaxArenas)
+        return stats;
+
+    const Arena& arena = s_arenas[document];
+    stats.document = document;
+    stats.name = document == 0 ? QString("global") : QString::fromUtf8(arena.name);
+    stats.closed = document != 0 && arena.state != kOpen;
+    stats.currentBytes = arena.current;
+    stats.peakBytes = arena.peak;
+    stats.reservedBytes = arena.reserved;
+    stats.allocations = arena.allocations;
+    stats.frees = arena.frees;
+    for (int i = 0; i < kClassCount; ++i) {
+        DwgSizeClassStats sizeClass;
+        sizeClass.size = kClassSizes[i];
+        sizeClass.live = arena.pools[i].live;
+        sizeClass.allocations = arena.pools[i].allocations;
+        stats.sizeClasses.append(sizeClass);
+    }
+    DwgSizeClassStats large;
+    large.live = arena.systemLive;
+    large.allocations = arena.systemAllocations;
+    stats.sizeClasses.append(large);
+    return stats;
+}
+
+QVector<DwgMemoryStats> allStats()
+{
+    QVector<DwgMemoryStats> result;
+    for (int i = 0; i < kMaxArenas; ++i) {
+        if (i == 0 || s_arenas[i].state != kFree)
+            result.append(stats(i));
+    }
+    return result;
+}
+
+DocumentScope::DocumentScope(int document)
+    : m_previous(t_document)
+{
+    t_document = document >= 0 && document < kMaxArenas ? document : 0;
+}
+
+DocumentScope::~DocumentScope()
+{
+    t_document = m_previous;
+}
+
+} // namespace DwgMemory
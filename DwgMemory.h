@@ -0,0 +1,73 @@
+#ifndef DWGMEMORY_H
+#define DWGMEMORY_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// Compteurs d'une classe de taille d'un document
+struct DwgSizeClassStats
+{
+    int size = 0;               // Taille des emplacements (0 : grands blocs, tas système)
+    quint64 live = 0;
+    quint64 allocations = 0;
+};
+
+struct DwgMemoryStats
+{
+    int document = 0;
+    QString name;
+    bool closed = false;
+    qint64 currentBytes = 0;    // Octets demandés encore alloués
+    qint64 peakBytes = 0;
+    qint64 reservedBytes = 0;   // Pages des pools, libres ou non
+    quint64 allocations = 0;
+    quint64 frees = 0;
+    QVector<DwgSizeClassStats> sizeClasses;
+};
+
+// Couche d'allocation derrière odrxAlloc / odrxRealloc / odrxFree (à la
+// place de TD_Alloc, voir DWG_POOLED_ALLOC dans DwgCommon.pri).
+// Chaque document a son arène : des pools par classe de taille (jusqu'à
+// 1 Ko, pages de 64 Ko) et des compteurs d'octets et d'allocations. Les
+// allocations sont attribuées au document de la portée DocumentScope du
+// thread courant (arène 0, "global", sinon) ; une libération revient
+// toujours à l'arène d'origine, quel que soit le thread. Les pages d'un
+// document fermé sont rendues en bloc quand sa dernière allocation est libérée.
+// setPooled(false) garde le comptage mais alloue sur le tas système, pour
+// comparer les deux.
+namespace DwgMemory
+{
+    void setPooled(bool pooled);
+    bool isPooled();
+
+    // Nouveau document (0 si toutes les arènes sont occupées : arène globale)
+    int createDocument(const QString& name);
+    // Plus aucune allocation attendue ; les pages partent avec la dernière libération
+    void closeDocument(int document);
+
+    // Association base <-> document, pour les threads qui ne connaissent que la base
+    void attach(const void* pDb, int document);
+    void detach(const void* pDb);
+    int documentFor(const void* pDb);
+
+    DwgMemoryStats stats(int document);
+    // Arène globale puis documents ouverts ou pas encore vidés
+    QVector<DwgMemoryStats> allStats();
+
+    // Attribue les allocations du thread courant à un document pour la durée de la portée
+    class DocumentScope
+    {
+    public:
+        explicit DocumentScope(int document);
+        ~DocumentScope();
+
+        DocumentScope(const DocumentScope&) = delete;
+        DocumentScope& operator=(const DocumentScope&) = delete;
+
+    private:
+        int m_previous;
+    };
+}
+
+#endif // DWGMEMORY_H
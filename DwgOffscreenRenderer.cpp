@@ -0,0 +1,183 @@
+#include "DwgOffscreenRenderer.h"
+#include "DwgPixelKernels.h"
+#include "MyServices.h"
+#include "DwgTrace.h"
+#include "Ge/GeVector3d.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include "DbGsManager.h"
+#include "Gi/GiRasterImage.h"
+#include "RxObjectImpl.h"
+#include "RxVariantValue.h"
+
+bool DwgGiContext::regenAbort() const
+{
+    return m_pAbort && m_pAbort->load(std::memory_order_relaxed);
+}
+
+DwgOffscreenRenderer::DwgOffscreenRenderer(OdDbDatabasePtr pDb, const OdDbObjectId& layoutId)
+    : m_pDb(pDb)
+    , m_layoutId(layoutId)
+{
+}
+
+DwgOffscreenRenderer::~DwgOffscreenRenderer()
+{
+    // Ordre inverse de la création : le helper référence le device
+    m_pHelper.release();
+    m_pDevice.release();
+    m_pGiCtx.release();
+}
+
+void DwgOffscreenRenderer::setAbortFlag(const std::atomic<bool>* pAbort)
+{
+    m_pAbort = pAbort;
+    if (!m_pGiCtx.isNull())
+        m_pGiCtx->setAbortFlag(pAbort);
+}
+
+bool DwgOffscreenRenderer::ensureDevice()
+{
+    if (!m_pHelper.isNull())
+        return true;
+
+    DWG_TRACE_SPAN("setupLayoutViews");
+
+    // Device bitmap hors écran : ni fenêtre ni DC, donc portable
+    OdGsDevicePtr pDevice = g_pServices->gsBitmapDevice();
+    if (pDevice.isNull()) {
+        qWarning() << "Failed to create bitmap device";
+        return false;
+    }
+
+    OdRxDictionaryPtr pProps = pDevice->properties();
+    if (!pProps.isNull() && pProps->has(OD_T("BitPerPixel")))
+        pProps->putAt(OD_T("BitPerPixel"), OdRxVariantValue(OdUInt32(24)));
+
+    pDevice->setBackgroundColor(ODRGB(255, 255, 255));
+
+    // Contexte
+    DwgGiContextPtr pGiCtx = OdRxObjectImpl<DwgGiContext>::createObject();
+    pGiCtx->setDatabase(m_pDb);
+    pGiCtx->setAbortFlag(m_pAbort);
+
+    // Setup layout
+    OdGsLayoutHelperPtr pHelper = m_layoutId.isNull()
+        ? OdDbGsManager::setupActiveLayoutViews(pDevice, pGiCtx)
+        : OdDbGsManager::setupLayoutViews(m_layoutId, pDevice, pGiCtx);
+    if (pHelper.isNull()) {
+        qWarning() << "Failed to setup layout helper";
+        return false;
+    }
+
+    m_pDevice = pDevice;
+    m_pGiCtx = pGiCtx;
+    m_pHelper = pHelper;
+    m_deviceSize = QSize();
+    return true;
+}
+
+bool DwgOffscreenRenderer::render(const QRectF& region, const QSize& size, QImage& image)
+{
+    if (m_pDb.isNull() || !g_pServices || region.isEmpty() || size.width() < 1 || size.height() < 1) {
+        return false;
+    }
+
+    DWG_TRACE_SPAN("render");
+
+    m_timings = DwgRenderTimings();
+    QElapsedTimer timer;
+
+    try {
+        timer.start();
+        if (!ensureDevice())
+            return false;
+        m_timings.setupNs = timer.nsecsElapsed();
+
+        if (size != m_deviceSize) {
+            OdGsDCRect rect(0, size.width(), size.height(), 0);
+            m_pHelper->onSize(rect);
+            m_deviceSize = size;
+        }
+
+        OdGsViewPtr pView = m_pHelper->activeView();
+        if (pView.isNull()) {
+            qWarning() << "No active view";
+            return false;
+        }
+
+        // Vue de dessus. Le device bitmap stocke ses lignes de bas en haut
+        // (convention DIB) : la copie les relit dans l'autre sens. Regarder
+        // par en dessous éviterait ce retournement mais inverserait le
+        // contenu 3D (faces cachées, ordre en profondeur)
+        const QPointF center = region.center();
+        OdGePoint3d target(center.x(), -center.y(), 0.0);
+        pView->setView(target + OdGeVector3d::kZAxis, target, OdGeVector3d::kYAxis,
+                       region.width(), region.height());
+
+        // RENDU : seules les vues sont régénérées, le cache GS est réutilisé
+        timer.restart();
+        {
+            DWG_TRACE_SPAN("deviceUpdate");
+            m_pDevice->update();
+        }
+        m_timings.updateNs = timer.nsecsElapsed();
+
+        if (m_pAbort && m_pAbort->load(std::memory_order_relaxed))
+            return false;
+
+        OdGiRasterImagePtr pRaster = m_pDevice->properties()->getAt(OD_T("RasterImage"));
+        if (pRaster.isNull()) {
+            qWarning() << "Bitmap device returned no raster image";
+            return false;
+        }
+
+        const int width = int(pRaster->pixelWidth());
+        const int height = int(pRaster->pixelHeight());
+        const int stride = int(pRaster->scanLineSize());
+        // 24 bits du device = octets B, G, R
+        if (pRaster->colorDepth() != 24 || width < 1 || height < 1) {
+            qWarning() << "Unexpected raster format:" << pRaster->colorDepth() << "bpp";
+            return false;
+        }
+
+        timer.restart();
+        DWG_TRACE_SPAN("rasterCopy");
+        // Le buffer appartient au device et sera réécrit au prochain rendu :
+        // une seule passe le détache, le remet à l'endroit et l'élargit en
+        // Format_RGB32, format natif de QPainter (un BGR888 serait reconverti
+        // à chaque affichage)
+        if (const OdUInt8* pBits = pRaster->scanLines()) {
+            image = DwgPixelKernels::imageFromBgr24(pBits, width, height, stride, true);
+        } else {
+            // Raster sans accès direct : copie en bloc puis même conversion
+            QByteArray bits(stride * height, Qt::Uninitialized);
+            pRaster->scanLines(reinterpret_cast<OdUInt8*>(bits.data()), 0, height);
+            image = DwgPixelKernels::imageFromBgr24(reinterpret_cast<const uchar*>(bits.constData()),
+                                                    width, height, stride, true);
+        }
+        m_timings.copyNs = timer.nsecsElapsed();
+
+        // DEBUG (DWG_DEBUG_IMAGES=1) : dernière image de chaque thread, un
+        // fichier par thread pour que deux rendus n'écrivent pas le même
+        if (DwgTrace::debugImagesEnabled()) {
+            DWG_TRACE_SPAN("debugImage");
+            const QString debugPath = QDir::temp().filePath(
+                QString("dwg_debug_%1.png").arg(quintptr(QThread::currentThreadId()), 0, 16));
+            image.save(debugPath);
+        }
+
+        return true;
+
+    } catch (const OdError& e) {
+        qWarning() << "Generation error:" << QString::fromStdWString((const wchar_t*)e.description().c_str());
+    } catch (...) {
+        qWarning() << "Unknown generation error";
+    }
+
+    return false;
+}
@@ -0,0 +1,70 @@
+#include "OdaCommon.h"
+
+#ifndef DWGOFFSCREENRENDERER_H
+#define DWGOFFSCREENRENDERER_H
+
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+
+#include <atomic>
+
+#include "DbDatabase.h"
+#include "DbGsManager.h"
+#include "GiContextForDbDatabase.h"
+
+// Contexte Gi qui permet d'interrompre une vectorisation en cours
+class DwgGiContext : public OdGiContextForDbDatabase
+{
+public:
+    void setAbortFlag(const std::atomic<bool>* pAbort) { m_pAbort = pAbort; }
+    bool regenAbort() const override;
+
+private:
+    const std::atomic<bool>* m_pAbort = nullptr;
+};
+typedef OdSmartPtr<DwgGiContext> DwgGiContextPtr;
+
+// Durées des étapes du dernier rendu, en nanosecondes (banc de mesure)
+struct DwgRenderTimings
+{
+    qint64 setupNs = 0;     // Device + setup(Active)LayoutViews (premier rendu seulement)
+    qint64 updateNs = 0;    // pDevice->update()
+    qint64 copyNs = 0;      // Copie du raster vers la QImage
+};
+
+// Rendu hors écran portable sur le device bitmap (OdWinBitmapModuleName),
+// sans fenêtre ni DC : fonctionne aussi sous Linux sans affichage.
+// Le device, le contexte et le layout helper sont créés une seule fois puis
+// réutilisés : les rendus suivants ne changent que la vue, et le cache GS
+// de géométrie vectorisée est conservé d'un rendu à l'autre.
+// Sans layoutId, la présentation active est rendue ; sinon la présentation
+// donnée, sans changer la présentation active de la base.
+class DwgOffscreenRenderer
+{
+public:
+    explicit DwgOffscreenRenderer(OdDbDatabasePtr pDb, const OdDbObjectId& layoutId = OdDbObjectId());
+    ~DwgOffscreenRenderer();
+
+    void setAbortFlag(const std::atomic<bool>* pAbort);
+
+    // Rend la région (coordonnées item, Y inversé) dans une image de la taille demandée
+    bool render(const QRectF& region, const QSize& size, QImage& image);
+
+    const DwgRenderTimings& lastTimings() const { return m_timings; }
+
+private:
+    bool ensureDevice();
+
+    OdDbDatabasePtr m_pDb;
+    OdDbObjectId m_layoutId;
+    const std::atomic<bool>* m_pAbort = nullptr;
+
+    OdGsDevicePtr m_pDevice;
+    DwgGiContextPtr m_pGiCtx;
+    OdGsLayoutHelperPtr m_pHelper;
+    QSize m_deviceSize;
+    DwgRenderTimings m_timings;
+};
+
+#endif // DWGOFFSCREENRENDERER_H
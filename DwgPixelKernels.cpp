@@ -0,0 +1,313 @@
+#include "DwgPixelKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DWG_PIXEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Les variantes SSSE3 / AVX2 sont compilées sans option globale du
+// compilateur (le binaire doit tourner sur tout x86-64) : attribut target
+// sous GCC / Clang, MSVC accepte les intrinsèques tels quels
+#if defined(DWG_PIXEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DWG_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DWG_TARGET(isa)
+#endif
+
+namespace {
+
+// Pixel XRGB32 : 0xffRRGGBB, soit en mémoire (petit-boutiste) B, G, R, 0xff
+void bgr24ToRgb32Scalar(const uchar* src, quint32* dst, int pixels)
+{
+    for (int i = 0; i < pixels; ++i, src += 3)
+        dst[i] = 0xff000000u | (quint32(src[2]) << 16) | (quint32(src[1]) << 8) | quint32(src[0]);
+}
+
+void rgb32ToRgb24Scalar(const quint32* src, uchar* dst, int pixels)
+{
+    for (int i = 0; i < pixels; ++i, dst += 3) {
+        dst[0] = uchar(src[i] >> 16);
+        dst[1] = uchar(src[i] >> 8);
+        dst[2] = uchar(src[i]);
+    }
+}
+
+// Moyenne arrondie de 2 x 2 pixels, canal par canal (alpha compris)
+void downsampleRow2xScalar(const quint32* row0, const quint32* row1, quint32* dst, int dstPixels)
+{
+    for (int i = 0; i < dstPixels; ++i) {
+        const quint32 a = row0[2 * i], b = row0[2 * i + 1];
+        const quint32 c = row1[2 * i], d = row1[2 * i + 1];
+        quint32 out = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            const quint32 sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff)
+                              + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+            out |= ((sum + 2) >> 2) << shift;
+        }
+        dst[i] = out;
+    }
+}
+
+#ifdef DWG_PIXEL_X86
+
+// 4 pixels (12 octets) par registre ; la lecture de 16 octets impose de
+// garder 16 octets lisibles, d'où la fin de ligne en scalaire
+DWG_TARGET("ssse3")
+void bgr24ToRgb32Ssse3(const uchar* src, quint32* dst, int pixels)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000u));
+    int i = 0;
+    for (; i + 6 <= pixels; i += 4) {
+        const __m128i bgr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i));
+        const __m128i rgb32 = _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), rgb32);
+    }
+    bgr24ToRgb32Scalar(src + 3 * i, dst + i, pixels - i);
+}
+
+// 4 pixels par registre, 12 octets utiles écrits : l'écriture de 16 octets
+// déborde sur les pixels suivants, d'où la fin de ligne en scalaire
+DWG_TARGET("ssse3")
+void rgb32ToRgb24Ssse3(const quint32* src, uchar* dst, int pixels)
+{
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    int i = 0;
+    for (; i + 6 <= pixels; i += 4) {
+        const __m128i rgb32 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * i), _mm_shuffle_epi8(rgb32, shuffle));
+    }
+    rgb32ToRgb24Scalar(src + i, dst + 3 * i, pixels - i);
+}
+
+// pshufb reste dans chaque moitié de 128 bits : 4 pixels chargés par moitié
+DWG_TARGET("avx2")
+void bgr24ToRgb32Avx2(const uchar* src, quint32* dst, int pixels)
+{
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                             0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000u));
+    int i = 0;
+    for (; i + 10 <= pixels; i += 8) {
+        const uchar* p = src + 3 * i;
+        const __m256i bgr = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        const __m256i rgb32 = _mm256_or_si256(_mm256_shuffle_epi8(bgr, shuffle), alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), rgb32);
+    }
+    bgr24ToRgb32Ssse3(src + 3 * i, dst + i, pixels - i);
+}
+
+// 4 pixels source par ligne -> 2 pixels ; sommes sur 16 bits, sans
+// l'arrondi cumulé de deux _mm_avg_epu8 successifs
+void downsampleRow2xSse2(const quint32* row0, const quint32* row1, quint32* dst, int dstPixels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(2);
+    int i = 0;
+    for (; i + 2 <= dstPixels; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * i));
+        // Pixels 0-1 et 2-3 des deux lignes, additionnés verticalement
+        const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        // Puis horizontalement : pixel 0 + 1, pixel 2 + 3
+        const __m128i sumLow = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+        const __m128i sumHigh = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+        const __m128i sums = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumLow, sumHigh), rounding), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(sums, zero));
+    }
+    downsampleRow2xScalar(row0 + 2 * i, row1 + 2 * i, dst + i, dstPixels - i);
+}
+
+// 8 pixels source par ligne -> 4 pixels
+DWG_TARGET("avx2")
+void downsampleRow2xAvx2(const quint32* row0, const quint32* row1, quint32* dst, int dstPixels)
+{
+    const __m256i rounding = _mm256_set1_epi16(2);
+    int i = 0;
+    for (; i + 4 <= dstPixels; i += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 2 * i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 2 * i));
+        const __m256i zero = _mm256_setzero_si256();
+        // Par moitié de 128 bits : pixels (0,1) en bas, (2,3) en haut
+        const __m256i low = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+        const __m256i high = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        const __m256i sumLow = _mm256_add_epi16(low, _mm256_srli_si256(low, 8));
+        const __m256i sumHigh = _mm256_add_epi16(high, _mm256_srli_si256(high, 8));
+        // Moitié basse : sorties 0, 1 ; moitié haute : sorties 2, 3
+        const __m256i sums = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(sumLow, sumHigh), rounding), 2);
+        const __m256i packed = _mm256_packus_epi16(sums, zero);
+        // Octets utiles : 64 bits de poids faible de chaque moitié
+        const __m128i out = _mm_unpacklo_epi64(_mm256_castsi256_si128(packed),
+                                               _mm256_extracti128_si256(packed, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+    }
+    downsampleRow2xSse2(row0 + 2 * i, row1 + 2 * i, dst + i, dstPixels - i);
+}
+
+DwgPixelKernels::Isa detectIsa()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return DwgPixelKernels::Avx2;
+    if (__builtin_cpu_supports("ssse3"))
+        return DwgPixelKernels::Ssse3;
+    return DwgPixelKernels::Sse2;
+#elif defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    // AVX2 utilisable seulement si le système sauvegarde les registres YMM
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return DwgPixelKernels::Avx2;
+    }
+    return ssse3 ? DwgPixelKernels::Ssse3 : DwgPixelKernels::Sse2;
+#else
+    return DwgPixelKernels::Sse2;
+#endif
+}
+
+#else
+
+DwgPixelKernels::Isa detectIsa()
+{
+    return DwgPixelKernels::Scalar;
+}
+
+#endif // DWG_PIXEL_X86
+
+} // namespace
+
+namespace DwgPixelKernels
+{
+
+Isa bestIsa()
+{
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+QString isaName(Isa isa)
+{
+    switch (isa) {
+    case Sse2: return QStringLiteral("sse2");
+    case Ssse3: return QStringLiteral("ssse3");
+    case Avx2: return QStringLiteral("avx2");
+    case Scalar: break;
+    }
+    return QStringLiteral("scalar");
+}
+
+// Une variante plus large que le processeur retombe sur la meilleure disponible
+void bgr24ToRgb32(const uchar* src, quint32* dst, int pixels, Isa isa)
+{
+    isa = qMin(isa, bestIsa());
+#ifdef DWG_PIXEL_X86
+    if (isa == Avx2)
+        return bgr24ToRgb32Avx2(src, dst, pixels);
+    if (isa == Ssse3)
+        return bgr24ToRgb32Ssse3(src, dst, pixels);
+#endif
+    bgr24ToRgb32Scalar(src, dst, pixels);
+}
+
+void bgr24ToRgb32(const uchar* src, quint32* dst, int pixels)
+{
+    bgr24ToRgb32(src, dst, pixels, bestIsa());
+}
+
+void rgb32ToRgb24(const quint32* src, uchar* dst, int pixels, Isa isa)
+{
+    isa = qMin(isa, bestIsa());
+#ifdef DWG_PIXEL_X86
+    if (isa >= Ssse3)
+        return rgb32ToRgb24Ssse3(src, dst, pixels);
+#endif
+    rgb32ToRgb24Scalar(src, dst, pixels);
+}
+
+void rgb32ToRgb24(const quint32* src, uchar* dst, int pixels)
+{
+    rgb32ToRgb24(src, dst, pixels, bestIsa());
+}
+
+void downsampleRow2x(const quint32* row0, const quint32* row1, quint32* dst, int dstPixels, Isa isa)
+{
+    isa = qMin(isa, bestIsa());
+#ifdef DWG_PIXEL_X86
+    if (isa == Avx2)
+        return downsampleRow2xAvx2(row0, row1, dst, dstPixels);
+    if (isa >= Sse2)
+        return downsampleRow2xSse2(row0, row1, dst, dstPixels);
+#endif
+    downsampleRow2xScalar(row0, row1, dst, dstPixels);
+}
+
+void downsampleRow2x(const quint32* row0, const quint32* row1, quint32* dst, int dstPixels)
+{
+    downsampleRow2x(row0, row1, dst, dstPixels, bestIsa());
+}
+
+QImage imageFromBgr24(const uchar* bits, int width, int height, int stride, bool bottomUp)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    if (image.isNull())
+        return image;
+
+    const Isa isa = bestIsa();
+    for (int y = 0; y < height; ++y) {
+        const int row = bottomUp ? height - 1 - y : y;
+        bgr24ToRgb32(bits + qptrdiff(row) * stride, reinterpret_cast<quint32*>(image.scanLine(y)), width, isa);
+    }
+    return image;
+}
+
+QImage downsample2x(const QImage& image)
+{
+    // La moyenne canal par canal n'est juste que sur des couleurs
+    // prémultipliées : un pixel transparent ne doit pas teinter ses voisins
+    QImage source = image;
+    if (source.format() == QImage::Format_ARGB32)
+        source = source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    else if (source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32_Premultiplied)
+        source = source.convertToFormat(QImage::Format_RGB32);
+
+    const int width = source.width();
+    const int height = source.height();
+    if (width < 2 || height < 2)
+        return source;
+
+    QImage result((width + 1) / 2, (height + 1) / 2, source.format());
+    if (result.isNull())
+        return result;
+
+    const Isa isa = bestIsa();
+    const int pairs = width / 2;
+    for (int y = 0; y < result.height(); ++y) {
+        // Ligne ou colonne impaire finale : le dernier pixel source est répété
+        const quint32* row0 = reinterpret_cast<const quint32*>(source.constScanLine(2 * y));
+        const quint32* row1 = reinterpret_cast<const quint32*>(source.constScanLine(qMin(2 * y + 1, height - 1)));
+        quint32* dst = reinterpret_cast<quint32*>(result.scanLine(y));
+        downsampleRow2x(row0, row1, dst, pairs, isa);
+        if (width & 1) {
+            const quint32 edge[2] = { row0[width - 1], row0[width - 1] };
+            const quint32 edgeBelow[2] = { row1[width - 1], row1[width - 1] };
+            downsampleRow2xScalar(edge, edgeBelow, dst + pairs, 1);
+        }
+    }
+    return result;
+}
+
+} // namespace DwgPixelKernels
@@ -0,0 +1,50 @@
+#ifndef DWGPIXELKERNELS_H
+#define DWGPIXELKERNELS_H
+
+#include <QImage>
+#include <QString>
+#include <QtGlobal>
+
+// Noyaux de pixels vectorisés du chemin raster, avec repli scalaire ; la
+// variante est choisie à l'exécution selon le processeur (bestIsa()).
+// - copie du raster GS (BGR 24 bits) vers Format_RGB32, permutation des
+//   canaux faite pendant la copie : le format natif de QPainter, sans
+//   conversion à chaque affichage ;
+// - RGB32 vers RVB 24 bits pour les exports ;
+// - réduction 2:1 par moyenne de 2 x 2 pixels (niveaux de mip) pour les
+//   tuiles affichées en dessous de leur résolution.
+namespace DwgPixelKernels
+{
+    enum Isa
+    {
+        Scalar,
+        Sse2,
+        Ssse3,
+        Avx2
+    };
+
+    Isa bestIsa();
+    QString isaName(Isa isa);
+
+    // Une ligne : src en octets B, G, R ; dst en pixels 0xffRRGGBB
+    void bgr24ToRgb32(const uchar* src, quint32* dst, int pixels, Isa isa);
+    void bgr24ToRgb32(const uchar* src, quint32* dst, int pixels);
+
+    // Sens inverse, pour l'écriture de fichiers : dst en octets R, G, B
+    void rgb32ToRgb24(const quint32* src, uchar* dst, int pixels, Isa isa);
+    void rgb32ToRgb24(const quint32* src, uchar* dst, int pixels);
+
+    // Deux lignes sources -> une ligne de dstPixels pixels (2 * dstPixels lus par ligne)
+    void downsampleRow2x(const quint32* row0, const quint32* row1, quint32* dst, int dstPixels, Isa isa);
+    void downsampleRow2x(const quint32* row0, const quint32* row1, quint32* dst, int dstPixels);
+
+    // Image Format_RGB32 détachée du buffer source ; bottomUp : la première
+    // ligne du buffer est celle du bas (DIB), retournée pendant la copie
+    QImage imageFromBgr24(const uchar* bits, int width, int height, int stride, bool bottomUp);
+
+    // Moitié de la taille (arrondie au supérieur), en RGB32 ou
+    // ARGB32_Premultiplied (ARGB32 est converti en prémultiplié)
+    QImage downsample2x(const QImage& image);
+}
+
+#endif // DWGPIXELKERNELS_H
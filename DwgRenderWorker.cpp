@@ -0,0 +1,333 @@
+#include "DwgRenderWorker.h"
+#include "DwgDiskCache.h"
+#include "DwgExtents.h"
+#include "DwgMemory.h"
+#include "DwgOffscreenRenderer.h"
+#include "DwgThreadScope.h"
+#include "DwgTrace.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSettings>
+
+#include <algorithm>
+#include <cstring>
+
+DwgRenderWorker::DwgRenderWorker(OdDbDatabasePtr pDb, QObject* parent)
+    : QObject(parent)
+    , m_pDb(pDb)
+{
+    qRegisterMetaType<DwgSpatialIndexPtr>();
+    qRegisterMetaType<DwgDisplayListPtr>();
+
+    const int threadCount = defaultThreadCount();
+
+    // Plusieurs vues lisent la base en même temps : verrous internes de Teigha en mode rendu multithread
+    if (threadCount > 1)
+        m_multiThreaded.reset(new DwgMultiThreadedMode(m_pDb.get()));
+
+    for (int i = 0; i < threadCount; ++i) {
+        std::unique_ptr<RenderSlot> slot(new RenderSlot());
+        RenderSlot* pSlot = slot.get();
+        const bool buildsIndex = (i == 0);
+        pSlot->thread = QThread::create([this, pSlot, buildsIndex]() { run(pSlot, buildsIndex); });
+        pSlot->thread->setObjectName(QString("DwgRenderWorker %1").arg(i));
+        m_slots.push_back(std::move(slot));
+    }
+}
+
+void DwgRenderWorker::start()
+{
+    for (const std::unique_ptr<RenderSlot>& slot : m_slots)
+        slot->thread->start(QThread::LowPriority);
+    DwgTrace::counter("renderThreads", qint64(m_slots.size()));
+}
+
+DwgRenderWorker::~DwgRenderWorker()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stop = true;
+        m_pending.clear();
+        for (const std::unique_ptr<RenderSlot>& slot : m_slots)
+            slot->abort = true;
+        m_wakeUp.wakeAll();
+    }
+    for (const std::unique_ptr<RenderSlot>& slot : m_slots) {
+        slot->thread->wait();
+        delete slot->thread;
+    }
+    m_multiThreaded.reset();
+
+    const DwgDiskCacheStats stats = DwgDiskCache::instance().stats();
+    qInfo() << "Disk tile cache:" << stats.hits << "hits," << stats.misses << "misses,"
+            << stats.writes << "writes," << stats.evictions << "evictions,"
+            << stats.bytes / (1024 * 1024) << "MB on disk";
+}
+
+int DwgRenderWorker::defaultThreadCount()
+{
+    // Chaque thread garde son propre cache GS : on plafonne par défaut
+    const int configured = QSettings().value("render/threads", 0).toInt();
+    if (configured > 0)
+        return configured;
+    return qBound(1, QThread::idealThreadCount(), 8);
+}
+
+void DwgRenderWorker::setProvisionalTileGrid(const DwgTileGrid& grid)
+{
+    QMutexLocker lock(&m_mutex);
+    // L'emprise exacte l'emporte sur celle de l'en-tête ou de la version précédente
+    if (m_extentsRefined)
+        return;
+    m_tileGrid = grid;
+    m_pending.clear();
+    for (const std::unique_ptr<RenderSlot>& slot : m_slots) {
+        if (slot->busy)
+            slot->abort = true;
+    }
+    if (m_displayListRequested)
+        m_wakeUp.wakeAll();
+}
+
+void DwgRenderWorker::requestTiles(const QVector<DwgTileKey>& keys, const QPointF& focus)
+{
+    QMutexLocker lock(&m_mutex);
+
+    // Les tuiles en cours restent utiles si elles font partie de la nouvelle
+    // demande. Un rendu déjà interrompu (demande ou grille précédente) sera
+    // jeté : sa clé repasse dans la file
+    QVector<bool> slotWanted(int(m_slots.size()), false);
+    m_pending.clear();
+    m_pending.reserve(keys.size());
+    for (const DwgTileKey& key : keys) {
+        bool inFlight = false;
+        for (int i = 0; i < int(m_slots.size()); ++i) {
+            if (m_slots[i]->busy && !m_slots[i]->abort && m_slots[i]->current == key) {
+                slotWanted[i] = true;
+                inFlight = true;
+            }
+        }
+        if (!inFlight)
+            m_pending.append(key);
+    }
+    for (int i = 0; i < int(m_slots.size()); ++i) {
+        if (m_slots[i]->busy && !slotWanted[i])
+            m_slots[i]->abort = true;
+    }
+
+    // Niveaux grossiers d'abord (replis de l'affichage progressif),
+    // puis du centre de la vue vers les bords
+    if (!m_tileGrid.isNull()) {
+        const DwgTileGrid& grid = m_tileGrid;
+        auto distance = [&grid, &focus](const DwgTileKey& key) {
+            const QPointF delta = grid.tileRect(key).center() - focus;
+            return delta.x() * delta.x() + delta.y() * delta.y();
+        };
+        std::stable_sort(m_pending.begin(), m_pending.end(), [&distance](const DwgTileKey& a, const DwgTileKey& b) {
+            if (a.level != b.level)
+                return a.level < b.level;
+            return distance(a) < distance(b);
+        });
+    }
+
+    if (!m_pending.isEmpty())
+        m_wakeUp.wakeAll();
+}
+
+void DwgRenderWorker::requestDisplayList()
+{
+    QMutexLocker lock(&m_mutex);
+    m_displayListRequested = true;
+    m_wakeUp.wakeAll();
+}
+
+void DwgRenderWorker::setSpatialIndex(const DwgSpatialIndexPtr& index)
+{
+    QMutexLocker lock(&m_mutex);
+    m_index = index;
+    // Le premier thread abandonne son builder au prochain passage
+    m_wakeUp.wakeAll();
+}
+
+void DwgRenderWorker::initDiskCache()
+{
+    DwgDiskCache& cache = DwgDiskCache::instance();
+    if (!cache.isEnabled())
+        return;
+
+    const OdString fileName = m_pDb->getFilename();
+    if (fileName.isEmpty())
+        return;
+
+    // Empreinte taille / date / extrémités : un fichier modifié ne retrouve pas ses anciennes tuiles
+    m_documentHash = DwgDiskCache::fileHash(QString::fromWCharArray((const wchar_t*)fileName.c_str()));
+
+    const OdString layoutHandle = m_pDb->currentLayoutId().getHandle().ascii();
+    m_layoutKey = QString::fromWCharArray((const wchar_t*)layoutHandle.c_str());
+}
+
+QByteArray DwgRenderWorker::diskCacheKey(const DwgTileGrid& grid, const DwgTileKey& key) const
+{
+    if (m_documentHash.isEmpty())
+        return QByteArray();
+
+    const QRectF bounds = grid.bounds();
+    const QString view = QString("tile %1/%2/%3 size %4 bounds %5 %6 %7 %8")
+                             .arg(key.level).arg(key.x).arg(key.y).arg(DwgTileGrid::kTileSize)
+                             .arg(bounds.x(), 0, 'g', 17).arg(bounds.y(), 0, 'g', 17)
+                             .arg(bounds.width(), 0, 'g', 17).arg(bounds.height(), 0, 'g', 17);
+    return DwgDiskCache::makeKey(m_documentHash, m_layoutKey, view);
+}
+
+void DwgRenderWorker::refineExtents()
+{
+    // L'emprise exacte ne dépend que du contenu : relue du cache à la réouverture
+    const QByteArray cacheKey = m_documentHash.isEmpty()
+        ? QByteArray() : DwgDiskCache::makeKey(m_documentHash, m_layoutKey, "extents");
+    QRectF bounds;
+    const QByteArray cached = DwgDiskCache::instance().loadData(cacheKey);
+    if (cached.size() == 4 * int(sizeof(double))) {
+        double values[4];
+        std::memcpy(values, cached.constData(), sizeof(values));
+        bounds = QRectF(values[0], values[1], values[2], values[3]);
+    } else {
+        bounds = DwgExtents::exactBounds(m_pDb.get());
+        if (bounds.isNull())
+            return;
+        const double values[4] = { bounds.x(), bounds.y(), bounds.width(), bounds.height() };
+        DwgDiskCache::instance().storeData(cacheKey, QByteArray(reinterpret_cast<const char*>(values), sizeof(values)));
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_extentsRefined = true;
+        if (m_tileGrid.bounds() != bounds) {
+            // Nouvelle grille : les tuiles de la grille provisoire sont abandonnées
+            m_tileGrid = DwgTileGrid(bounds);
+            m_pending.clear();
+            for (const std::unique_ptr<RenderSlot>& slot : m_slots) {
+                if (slot->busy)
+                    slot->abort = true;
+            }
+        }
+        // Sous le verrou : aucune tuile de l'ancienne grille ne peut être publiée après
+        emit extentsReady(bounds);
+    }
+}
+
+void DwgRenderWorker::publishTile(const DwgTileGrid& grid, const DwgTileKey& key, const QImage& image)
+{
+    // Une tuile rendue pour une grille remplacée entre-temps n'a plus de sens
+    QMutexLocker lock(&m_mutex);
+    if (grid.bounds() == m_tileGrid.bounds())
+        emit tileReady(grid.bounds(), key, image);
+}
+
+void DwgRenderWorker::run(RenderSlot* slot, bool buildsIndex)
+{
+    DwgThreadScope threadScope;
+    // Objets chargés à la demande, caches de vectorisation : comptés avec le document
+    DwgMemory::DocumentScope memoryScope(DwgMemory::documentFor(m_pDb.get()));
+
+    // Le renderer ne crée son device qu'au premier rendu réel : sur des
+    // succès du cache disque, le pipeline GS n'est jamais sollicité
+    DwgOffscreenRenderer renderer(m_pDb);
+    renderer.setAbortFlag(&slot->abort);
+
+    std::call_once(m_diskCacheOnce, [this]() { initDiskCache(); });
+    if (buildsIndex) {
+        refineExtents();
+        m_indexBuilder.reset(new DwgSpatialIndexBuilder(m_pDb.get()));
+    }
+
+    // Tuile vide partagée, même format que les tuiles rendues
+    QImage blankTile(DwgTileGrid::kTileSize, DwgTileGrid::kTileSize, QImage::Format_RGB32);
+    blankTile.fill(Qt::white);
+
+    for (;;) {
+        DwgTileKey key;
+        DwgTileGrid grid;
+        DwgSpatialIndexPtr index;
+        bool indexWork = false;
+        bool displayListWork = false;
+        {
+            QMutexLocker lock(&m_mutex);
+            slot->busy = false;
+            if (buildsIndex && m_indexBuilder && m_index)
+                m_indexBuilder.reset();
+            // La liste d'affichage attend que l'emprise (grille) soit connue
+            const auto displayListDue = [&]() { return m_displayListRequested && !m_tileGrid.isNull(); };
+            while (!m_stop && m_pending.isEmpty() && !(buildsIndex && (m_indexBuilder || displayListDue())))
+                m_wakeUp.wait(&m_mutex);
+            if (m_stop)
+                break;
+
+            if (buildsIndex && displayListDue()) {
+                displayListWork = true;
+                m_displayListRequested = false;
+                grid = m_tileGrid;
+                slot->abort = false;
+            } else if (m_pending.isEmpty()) {
+                indexWork = true;
+            } else {
+                key = m_pending.takeFirst();
+                grid = m_tileGrid;
+                index = m_index;
+                slot->current = key;
+                slot->busy = true;
+                slot->abort = false;
+            }
+        }
+
+        if (displayListWork) {
+            // Les autres threads continuent à produire des tuiles en attendant
+            DwgDisplayListPtr list = DwgDisplayList::build(m_pDb.get(), grid.bounds(), &slot->abort);
+            if (list)
+                emit displayListReady(list);
+            continue;
+        }
+
+        if (indexWork) {
+            // Petite tranche : une nouvelle demande de tuiles attend au plus quelques ms
+            DWG_TRACE_SPAN("spatialIndex");
+            if (!m_indexBuilder->step(2048)) {
+                DwgSpatialIndexPtr built = m_indexBuilder->finish();
+                m_indexBuilder.reset();
+                if (built) {
+                    {
+                        QMutexLocker lock(&m_mutex);
+                        m_index = built;
+                    }
+                    emit indexReady(built);
+                }
+            }
+            continue;
+        }
+
+        // Aucune entité dans la tuile (marge d'un pixel pour l'épaisseur des
+        // traits) : pas de vectorisation ni d'accès disque
+        if (index && index->isComplete()) {
+            const QRectF rect = grid.tileRect(key);
+            const qreal margin = rect.width() / DwgTileGrid::kTileSize;
+            if (!index->intersectsAny(rect.adjusted(-margin, -margin, margin, margin))) {
+                publishTile(grid, key, blankTile);
+                continue;
+            }
+        }
+
+        DWG_TRACE_SPAN("tile");
+        const QByteArray cacheKey = diskCacheKey(grid, key);
+        QImage image = DwgDiskCache::instance().load(cacheKey);
+        if (image.isNull()) {
+            const QSize size(DwgTileGrid::kTileSize, DwgTileGrid::kTileSize);
+            if (!renderer.render(grid.tileRect(key), size, image) || slot->abort)
+                continue;
+            DwgDiskCache::instance().store(cacheKey, image);
+        }
+        publishTile(grid, key, image);
+    }
+
+    if (buildsIndex)
+        m_indexBuilder.reset();
+}
@@ -0,0 +1,117 @@
+#include "OdaCommon.h"
+
+#ifndef DWGRENDERWORKER_H
+#define DWGRENDERWORKER_H
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QPointF>
+#include <QRectF>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "DbDatabase.h"
+
+#include "DwgDisplayList.h"
+#include "DwgSpatialIndex.h"
+#include "DwgThreadScope.h"
+#include "DwgTileGrid.h"
+
+// Threads de rendu propriétaires de la vectorisation Teigha.
+// Chaque thread a son propre device bitmap et sa vue sur la base partagée
+// (mode multithread de Teigha). Tous puisent dans une file commune triée
+// par distance au centre de la vue ; chaque nouvelle demande remplace la
+// précédente : les tuiles qui ne sont plus visibles sont abandonnées, y
+// compris celles en cours de rendu.
+// Entre deux demandes, le premier thread construit l'index spatial des
+// entités par tranches ; une fois prêt il sert à ne pas vectoriser les
+// tuiles vides. Ce même thread construit la liste d'affichage vectorielle
+// quand elle est demandée, avant toute autre tâche.
+// Au démarrage, ce thread calcule l'emprise exacte (ou la relit dans le
+// cache disque) et remplace la grille provisoire issue de l'en-tête.
+class DwgRenderWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DwgRenderWorker(OdDbDatabasePtr pDb, QObject* parent = nullptr);
+    ~DwgRenderWorker();
+
+    // Démarre les threads ; à appeler une fois les signaux connectés, sans
+    // quoi l'emprise ou les premières tuiles peuvent être émises sans récepteur
+    void start();
+
+    // Réglage "render/threads" (0 ou absent : nombre de cœurs, 8 au plus)
+    static int defaultThreadCount();
+
+    // Grille tant que l'emprise exacte n'est pas connue (en-tête, version
+    // précédente au rechargement) ; sans effet une fois extentsReady() émis
+    void setProvisionalTileGrid(const DwgTileGrid& grid);
+
+    // Remplace la file d'attente ; les niveaux les plus grossiers puis les
+    // tuiles les plus proches de focus (coordonnées item) sont rendus en premier
+    void requestTiles(const QVector<DwgTileKey>& keys, const QPointF& focus);
+
+    // Vectorisation unique de l'espace objet (mode vectoriel), publiée par displayListReady()
+    void requestDisplayList();
+
+    // Index déjà construit pour cette base (rechargement) : le parcours par
+    // tranches du premier thread n'a pas lieu
+    void setSpatialIndex(const DwgSpatialIndexPtr& index);
+
+signals:
+    // gridBounds : emprise de la grille pour laquelle la tuile a été rendue
+    void tileReady(const QRectF& gridBounds, const DwgTileKey& key, const QImage& image);
+    // Emprise exacte, émise une fois ; la grille du worker est déjà à jour
+    void extentsReady(const QRectF& bounds);
+    void indexReady(const DwgSpatialIndexPtr& index);
+    void displayListReady(const DwgDisplayListPtr& displayList);
+
+private:
+    // État d'un thread de rendu ; busy et current sont protégés par m_mutex
+    struct RenderSlot
+    {
+        QThread* thread = nullptr;
+        DwgTileKey current;
+        bool busy = false;
+        // Lu par DwgGiContext::regenAbort() pendant le rendu
+        std::atomic<bool> abort { false };
+    };
+
+    void run(RenderSlot* slot, bool buildsIndex);
+    void initDiskCache();
+    void refineExtents();
+    void publishTile(const DwgTileGrid& grid, const DwgTileKey& key, const QImage& image);
+    QByteArray diskCacheKey(const DwgTileGrid& grid, const DwgTileKey& key) const;
+
+    OdDbDatabasePtr m_pDb;
+    std::unique_ptr<DwgMultiThreadedMode> m_multiThreaded;
+    std::vector<std::unique_ptr<RenderSlot>> m_slots;
+
+    // Clé du document pour le cache disque (calculée une fois, par le premier thread prêt)
+    std::once_flag m_diskCacheOnce;
+    QByteArray m_documentHash;
+    QString m_layoutKey;
+
+    // Index spatial (premier thread uniquement tant qu'il n'est pas publié)
+    std::unique_ptr<DwgSpatialIndexBuilder> m_indexBuilder;
+    DwgSpatialIndexPtr m_index;     // Protégé par m_mutex
+
+    // Protégé par m_mutex
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;
+    DwgTileGrid m_tileGrid;
+    bool m_extentsRefined = false;
+    QVector<DwgTileKey> m_pending;
+    bool m_displayListRequested = false;
+    bool m_stop = false;
+};
+
+#endif // DWGRENDERWORKER_H
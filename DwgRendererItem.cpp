@@ -1,23 +1,34 @@
 #include "DwgRendererItem.h"
-#include "Ge/GeExtents3d.h"
+#include "DwgExtents.h"
+#include "DwgPixelKernels.h"
+#include "DwgRenderWorker.h"
+#include "DwgTrace.h"
 #include <OdaCommon.h>
 
-#include <QDebug>
+#include <QGraphicsSceneHoverEvent>
 #include <QGraphicsSceneWheelEvent>
 #include <QPainter>
-#include <QDir>
-#include <QFile>
+#include <QStyleOptionGraphicsItem>
 #include <QWidget>
 
-#include "DbGsManager.h"
-#include "GiContextForDbDatabase.h"
 #include "OdModuleNames.h"
-#include "RxDynamicModule.h"
-#include "RxRasterServices.h"
-#include "RxVariantValue.h"
 
-#include <windows.h>
+// Budget mémoire du cache de tuiles, en Ko (coût d'une tuile = sa taille en Ko)
+static const int kTileCacheBudgetKb = 256 * 1024;
 
+// Budget des tuiles pré-mises à l'échelle, en Ko (quelques écrans 4K)
+static const int kScaledTileBudgetKb = 128 * 1024;
+
+// Budget des niveaux de mip, en Ko (un quart des tuiles pleine résolution)
+static const int kMipTileBudgetKb = 64 * 1024;
+
+// En dessous de ce rapport pixels écran / pixels de tuile, la tuile est
+// affichée depuis son mip : le lissage bilinéaire de QPainter ne lit que
+// 2 x 2 pixels et crénelle les traits fins au-delà d'une réduction de ~1,4
+static const qreal kMipThreshold = 0.7071;
+
+// Tolérance de picking autour du curseur, en pixels écran
+static const qreal kPickTolerancePx = 4.0;
 
 DwgRendererItem::DwgRendererItem(OdDbDatabasePtr pDb, QGraphicsItem* parent)
     : QGraphicsObject(parent)
@@ -27,10 +38,30 @@ DwgRendererItem::DwgRendererItem(OdDbDatabasePtr pDb, QGraphicsItem* parent)
     setAcceptHoverEvents(true);
     setFlag(QGraphicsItem::ItemIsFocusable);
     setFlag(QGraphicsItem::ItemIsSelectable);
+    // Nécessaire pour que option->exposedRect soit renseigné dans paint()
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    m_tiles.setMaxCost(kTileCacheBudgetKb);
+    m_scaledTiles.setMaxCost(kScaledTileBudgetKb);
+    m_mipTiles.setMaxCost(kMipTileBudgetKb);
+
+    // Le worker est le seul à vectoriser : paint() ne fait qu'afficher le cache
+    m_worker.reset(new DwgRenderWorker(m_pDb));
+    connect(m_worker.get(), &DwgRenderWorker::tileReady,
+            this, &DwgRendererItem::onTileReady, Qt::QueuedConnection);
+    connect(m_worker.get(), &DwgRenderWorker::extentsReady,
+            this, &DwgRendererItem::onExtentsReady, Qt::QueuedConnection);
+    connect(m_worker.get(), &DwgRenderWorker::indexReady,
+            this, &DwgRendererItem::onIndexReady, Qt::QueuedConnection);
+    connect(m_worker.get(), &DwgRenderWorker::displayListReady,
+            this, &DwgRendererItem::onDisplayListReady, Qt::QueuedConnection);
+    m_worker->start();
 }
 
 DwgRendererItem::~DwgRendererItem()
 {
+    // Arrête le thread de rendu avant que l'item ne disparaisse
+    m_worker.reset();
 }
 
 void DwgRendererItem::ensureExtentsValid() const
@@ -38,36 +69,37 @@ void DwgRendererItem::ensureExtentsValid() const
     if(m_bExtentsCalculated)
         return;
 
+    // Emprise de l'en-tête tout de suite, sans parcourir les entités :
+    // l'emprise exacte arrive ensuite par onExtentsReady()
     m_cachedBoundingRect = QRectF(0, 0, 1000, 1000);
 
-    if(!m_pDb.isNull()) {
-        try {
-            OdGeExtents3d extents;
-            if(m_pDb->getGeomExtents(extents) == eOk && extents.isValidExtents()) {
-                OdGePoint3d min = extents.minPoint();
-                OdGePoint3d max = extents.maxPoint();
-
-                if(min.distanceTo(max) < 1.0) {
-                    min.x -= 50.0;
-                    min.y -= 50.0;
-                    max.x += 50.0;
-                    max.y += 50.0;
-                }
-
-                double w = max.x - min.x;
-                double h = max.y - min.y;
-
-                double limit = 10000000.0;
-                if(w > limit || h > limit || qAbs(min.x) > limit || qAbs(min.y) > limit) {
-                    m_cachedBoundingRect = QRectF(-limit / 2, -limit / 2, limit, limit);
-                } else {
-                    m_cachedBoundingRect = QRectF(min.x, min.y, w, h);
-                }
-            }
-        } catch(...) {
-        }
-    }
+    const QRectF bounds = DwgExtents::headerBounds(m_pDb.get());
+    if(!bounds.isNull())
+        m_cachedBoundingRect = bounds;
+
+    m_bExtentsCalculated = true;
+    m_tileGrid = DwgTileGrid(m_cachedBoundingRect);
+    m_worker->setProvisionalTileGrid(m_tileGrid);
+}
+
+void DwgRendererItem::onExtentsReady(const QRectF& bounds)
+{
+    if (m_bExtentsCalculated && bounds == m_cachedBoundingRect)
+        return;
+
+    prepareGeometryChange();
+    m_cachedBoundingRect = bounds;
     m_bExtentsCalculated = true;
+    // Le worker est déjà passé à cette grille
+    m_tileGrid = DwgTileGrid(bounds);
+
+    // Les tuiles de la grille provisoire ne correspondent plus : l'aperçu
+    // reprend le relais le temps que la nouvelle tuile racine arrive
+    m_tiles.clear();
+    m_scaledTiles.clear();
+    m_mipTiles.clear();
+    m_staleTiles.clear();
+    update();
 }
 
 QRectF DwgRendererItem::boundingRect() const
@@ -76,276 +108,336 @@ QRectF DwgRendererItem::boundingRect() const
     return m_cachedBoundingRect;
 }
 
-// bool DwgRendererItem::generateImage(const QSize& size)
-// {
-//     if (m_imageGenerated) {
-//         return true;  // Généré une seule fois
-//     }
-
-//     if (m_pDb.isNull() || size.width() < 1 || size.height() < 1) {
-//         return false;
-//     }
-
-//     qDebug() << "Generating DWG image at size:" << size;
-
-//     try {
-//         // Créer device bitmap
-//         OdGsModulePtr pGsModule = odrxDynamicLinker()->loadModule(m_gsDeviceModuleName);
-//         if (pGsModule.isNull()) {
-//             qWarning() << "Failed to load GS module";
-//             return false;
-//         }
-
-//         OdGsDevicePtr pDevice = pGsModule->createDevice();
-//         if (pDevice.isNull()) {
-//             qWarning() << "Failed to create device";
-//             return false;
-//         }
-
-//         // Configuration
-//         OdRxDictionaryPtr pProps = pDevice->properties();
-//         if (!pProps.isNull()) {
-//             if (pProps->has(OD_T("BitPerPixel")))
-//                 pProps->putAt(OD_T("BitPerPixel"), OdRxVariantValue(OdUInt32(24)));
-//         }
-
-//         pDevice->setBackgroundColor(ODRGB(255, 255, 255));
-
-//         // Contexte
-//         OdGiContextForDbDatabasePtr pGiCtx = OdGiContextForDbDatabase::createObject();
-//         pGiCtx->setDatabase(m_pDb);
-
-//         // Setup layout
-//         OdGsLayoutHelperPtr pHelper = OdDbGsManager::setupActiveLayoutViews(pDevice, pGiCtx);
-
-//         if (pHelper.isNull()) {
-//             qWarning() << "Failed to setup layout helper";
-//             return false;
-//         }
-
-//         // Taille - utilisez une grande résolution pour meilleure qualité au zoom
-//         int renderWidth = size.width() * 2;   // 2x pour meilleure qualité
-//         int renderHeight = size.height() * 2;
-
-//         OdGsDCRect rect(0, renderWidth, renderHeight, 0);
-//         pHelper->onSize(rect);
-
-//         // RENDU
-//         // Essayer d'obtenir le snapshot directement
-//         OdGiRasterImagePtr pRasImg;
-//         pDevice->getSnapShot(pRasImg, rect);
-
-//         if (!pRasImg.isNull()) {
-//             qDebug() << "Raster image obtained, size:" << pRasImg->pixelWidth() << "x" << pRasImg->pixelHeight();
-
-//             // Convertir directement en QImage sans passer par un fichier
-//             int width = (int)pRasImg->pixelWidth();
-//             int height = (int)pRasImg->pixelHeight();
-//             int bpp = (int)pRasImg->colorDepth();
-
-//             if (width > 0 && height > 0) {
-//                 QImage::Format fmt = (bpp == 32) ? QImage::Format_RGB32 : QImage::Format_RGB888;
-//                 m_cachedImage = QImage(width, height, fmt);
-
-//                 OdUInt32 scnLnSize = pRasImg->scanLineSize();
-//                 OdUInt32 bytesPerPixel = (bpp + 7) / 8;
-//                 OdUInt32 rowSize = width * bytesPerPixel;
-
-//                 // Copier les scanlines
-//                 for (int y = 0; y < height; ++y) {
-//                     const OdUInt8* srcLine = pRasImg->scanLines() + y * scnLnSize;
-//                     OdUInt8* dstLine = m_cachedImage.scanLine(y);
-//                     memcpy(dstLine, srcLine, qMin((OdUInt32)m_cachedImage.bytesPerLine(), rowSize));
-//                 }
-
-//                 // RGB -> BGR swap
-//                 m_cachedImage = m_cachedImage.rgbSwapped();
-//                 m_imageGenerated = true;
-//                 qDebug() << "Image generated successfully";
-//                 return true;
-//             }
-//         }
-
-//         qWarning() << "Failed to get snapshot from device";
-
-//         qWarning() << "Failed to export raster image";
-
-//     } catch (const OdError& e) {
-//         qWarning() << "Generation error:" << QString::fromStdWString((const wchar_t*)e.description().c_str());
-//     } catch (...) {
-//         qWarning() << "Unknown generation error";
-//     }
-
-//     return false;
-// }
-
-bool DwgRendererItem::generateImage(const QSize& size)
+void DwgRendererItem::onTileReady(const QRectF& gridBounds, const DwgTileKey& key, const QImage& image)
 {
-    if (m_imageGenerated) {
-        return true;
-    }
+    // Tuile de la grille exacte encore en file alors que l'item affiche la
+    // grille provisoire, ou l'inverse : même clé, autre zone du dessin
+    if (gridBounds != m_tileGrid.bounds())
+        return;
 
-    if (m_pDb.isNull() || size.width() < 1 || size.height() < 1) {
-        return false;
-    }
+    const int costKb = qMax<qsizetype>(1, image.sizeInBytes() / 1024);
+    m_tiles.insert(key, new QImage(image), costKb);
+    m_staleTiles.remove(key);
+    m_scaledTiles.remove(key);
+    m_mipTiles.remove(key);
+    update(m_tileGrid.tileRect(key));
+}
 
-    qDebug() << "Generating DWG image at size:" << size;
-
-    // Variables Windows
-    HWND hTempWnd = nullptr;
-    HDC hTempDC = nullptr;
-    HBITMAP hBitmap = nullptr;
-    HBITMAP hOldBitmap = nullptr;
-    void* pBits = nullptr;
-
-    try {
-        int renderWidth = size.width() * 2;
-        int renderHeight = size.height() * 2;
-
-        // Créer une fenêtre temporaire invisible
-        hTempWnd = CreateWindowExW(
-            0, L"STATIC", L"TeighaTemp",
-            WS_POPUP,
-            0, 0, renderWidth, renderHeight,
-            nullptr, nullptr, GetModuleHandle(nullptr), nullptr
-            );
-
-        if (!hTempWnd) {
-            qWarning() << "Failed to create temp window";
-            return false;
-        }
+void DwgRendererItem::setPrescaledTiles(bool enabled)
+{
+    m_prescaledTiles = enabled;
+    m_scaledTiles.clear();
+    update();
+}
 
-        hTempDC = GetDC(hTempWnd);
-        if (!hTempDC) {
-            DestroyWindow(hTempWnd);
-            return false;
-        }
+void DwgRendererItem::setPreview(const QImage& preview)
+{
+    m_preview = preview;
+    update();
+}
 
-        // Créer DIB
-        BITMAPINFO bmi;
-        ZeroMemory(&bmi, sizeof(BITMAPINFO));
-        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-        bmi.bmiHeader.biWidth = renderWidth;
-        bmi.bmiHeader.biHeight = -renderHeight;  // Top-down
-        bmi.bmiHeader.biPlanes = 1;
-        bmi.bmiHeader.biBitCount = 24;
-        bmi.bmiHeader.biCompression = BI_RGB;
-
-        hBitmap = CreateDIBSection(hTempDC, &bmi, DIB_RGB_COLORS, &pBits, nullptr, 0);
-        if (!hBitmap) {
-            qWarning() << "Failed to create DIB";
-            ReleaseDC(hTempWnd, hTempDC);
-            DestroyWindow(hTempWnd);
-            return false;
-        }
+void DwgRendererItem::onIndexReady(const DwgSpatialIndexPtr& index)
+{
+    m_index = index;
+}
 
-        hOldBitmap = (HBITMAP)SelectObject(hTempDC, hBitmap);
+void DwgRendererItem::setSpatialIndex(const DwgSpatialIndexPtr& index)
+{
+    m_index = index;
+    m_worker->setSpatialIndex(index);
+}
 
-        // Créer device GDI
-        OdGsModulePtr pGsModule = odrxDynamicLinker()->loadModule(OdWinGDIModuleName);
-        if (pGsModule.isNull()) {
-            qWarning() << "Failed to load WinGDI module";
-            throw OdError(eNullPtr);
-        }
+DwgTileSnapshotPtr DwgRendererItem::tileSnapshot() const
+{
+    if (!m_bExtentsCalculated || m_tileGrid.isNull())
+        return DwgTileSnapshotPtr();
+
+    std::shared_ptr<DwgTileSnapshot> snapshot(new DwgTileSnapshot());
+    snapshot->bounds = m_cachedBoundingRect;
+    snapshot->grid = m_tileGrid;
+    snapshot->index = m_index;
+    const QList<DwgTileKey> keys = m_tiles.keys();
+    for (const DwgTileKey& key : keys) {
+        const QImage* tile = m_tiles.object(key);
+        if (!tile)
+            continue;
+        snapshot->tiles.insert(key, *tile);
+        if (m_staleTiles.contains(key))
+            snapshot->staleTiles.insert(key);
+        else if (const QImage* mip = m_mipTiles.object(key))
+            snapshot->mipTiles.insert(key, *mip);
+    }
+    return snapshot;
+}
 
-        OdGsDevicePtr pDevice = pGsModule->createDevice();
-        if (pDevice.isNull()) {
-            qWarning() << "Failed to create device";
-            throw OdError(eNullPtr);
-        }
+void DwgRendererItem::adoptTiles(const DwgTileSnapshot& previous, const QVector<QRectF>& changedRegions,
+                                 bool allChanged)
+{
+    if (previous.grid.isNull())
+        return;
 
-        // Configuration avec notre DC
-        OdRxDictionaryPtr pProps = pDevice->properties();
-        if (!pProps.isNull()) {
-            pProps->putAt(OD_T("WindowHWND"), OdRxVariantValue((OdIntPtr)hTempWnd));
-            pProps->putAt(OD_T("WindowHDC"), OdRxVariantValue((OdIntPtr)hTempDC));
+    // Même grille que l'item précédent, donc mêmes clés de tuiles ; si
+    // l'emprise exacte de la nouvelle version diffère, onExtentsReady()
+    // change de grille et repart de zéro. Le worker garde sa grille s'il a
+    // déjà calculé l'emprise exacte : son extentsReady() est alors en file
+    prepareGeometryChange();
+    m_cachedBoundingRect = previous.bounds;
+    m_bExtentsCalculated = true;
+    m_tileGrid = previous.grid;
+    m_worker->setProvisionalTileGrid(m_tileGrid);
+
+    int stale = 0;
+    for (auto it = previous.tiles.cbegin(); it != previous.tiles.cend(); ++it) {
+        const DwgTileKey& key = it.key();
+        const QImage& tile = it.value();
+
+        // Marge d'un pixel de tuile pour l'épaisseur des traits, comme le
+        // test de tuile vide du worker
+        bool changed = allChanged || previous.staleTiles.contains(key);
+        const QRectF rect = m_tileGrid.tileRect(key);
+        const qreal margin = rect.width() / DwgTileGrid::kTileSize;
+        for (int i = 0; i < changedRegions.size() && !changed; ++i)
+            changed = rect.intersects(changedRegions.at(i).adjusted(-margin, -margin, margin, margin));
+
+        m_tiles.insert(key, new QImage(tile), qMax<qsizetype>(1, tile.sizeInBytes() / 1024));
+        if (changed) {
+            m_staleTiles.insert(key);
+            ++stale;
+        } else if (previous.mipTiles.contains(key)) {
+            const QImage& mip = previous.mipTiles[key];
+            m_mipTiles.insert(key, new QImage(mip), qMax<qsizetype>(1, mip.sizeInBytes() / 1024));
         }
+    }
+    DwgTrace::counter("reloadTilesReused", previous.tiles.size() - stale);
+    DwgTrace::counter("reloadTilesStale", stale);
+    update();
+}
 
-        pDevice->setBackgroundColor(ODRGB(255, 255, 255));
+void DwgRendererItem::setVectorMode(bool enabled)
+{
+    if (enabled == m_vectorMode)
+        return;
 
-        // Contexte
-        OdGiContextForDbDatabasePtr pGiCtx = OdGiContextForDbDatabase::createObject();
-        pGiCtx->setDatabase(m_pDb);
+    m_vectorMode = enabled;
+    if (m_vectorMode)
+        requestDisplayList();
+    update();
+}
 
-        // Setup layout
-        OdGsLayoutHelperPtr pHelper = OdDbGsManager::setupActiveLayoutViews(pDevice, pGiCtx);
+void DwgRendererItem::setLayerVisible(const QString& name, bool visible)
+{
+    if (visible == !m_hiddenLayers.contains(name))
+        return;
 
-        if (pHelper.isNull()) {
-            qWarning() << "Failed to setup layout helper";
-            throw OdError(eNullPtr);
-        }
+    if (visible)
+        m_hiddenLayers.remove(name);
+    else
+        m_hiddenLayers.insert(name);
+    if (usesDisplayList())
+        requestDisplayList();
+    updateHiddenLayerMask();
+    update();
+}
 
-        OdGsDCRect rect(0, renderWidth, renderHeight, 0);
-        pHelper->onSize(rect);
+void DwgRendererItem::requestDisplayList()
+{
+    if (m_displayListRequested)
+        return;
+    m_displayListRequested = true;
+    m_worker->requestDisplayList();
+}
 
-        // RENDU
-        qDebug() << "Rendering to DC...";
-        pDevice->update();
-        qDebug() << "Render complete";
+void DwgRendererItem::updateHiddenLayerMask()
+{
+    m_hiddenLayerMask.clear();
+    if (!m_displayList || m_hiddenLayers.isEmpty())
+        return;
 
-        // Copier le DIB vers QImage
-        if (pBits) {
-            int stride = ((renderWidth * 3 + 3) & ~3);
-            m_cachedImage = QImage(renderWidth, renderHeight, QImage::Format_RGB888);
+    const QStringList& names = m_displayList->layerNames();
+    m_hiddenLayerMask.resize(names.size());
+    for (int i = 0; i < names.size(); ++i)
+        m_hiddenLayerMask[i] = m_hiddenLayers.contains(names.at(i));
+}
 
-            for (int y = 0; y < renderHeight; ++y) {
-                const OdUInt8* srcLine = (const OdUInt8*)pBits + y * stride;
-                OdUInt8* dstLine = m_cachedImage.scanLine(y);
-                memcpy(dstLine, srcLine, renderWidth * 3);
-            }
+void DwgRendererItem::onDisplayListReady(const DwgDisplayListPtr& displayList)
+{
+    m_displayList = displayList;
+    updateHiddenLayerMask();
+    if (usesDisplayList())
+        update();
+}
 
-            m_cachedImage = m_cachedImage.rgbSwapped();
+bool DwgRendererItem::drawFallback(QPainter* painter, const DwgTileKey& key)
+{
+    // Remonte la pyramide jusqu'à trouver une tuile plus grossière déjà rendue
+    const QRectF target = m_tileGrid.tileRect(key);
+    DwgTileKey ancestor = key;
+    while (ancestor.level > 0) {
+        ancestor = DwgTileGrid::parentOf(ancestor);
+        const QImage* image = m_tiles.object(ancestor);
+        if (!image)
+            continue;
+
+        const QRectF ancestorRect = m_tileGrid.tileRect(ancestor);
+        const qreal sx = image->width() / ancestorRect.width();
+        const qreal sy = image->height() / ancestorRect.height();
+        const QRectF source((target.left() - ancestorRect.left()) * sx,
+                            (target.top() - ancestorRect.top()) * sy,
+                            target.width() * sx, target.height() * sy);
+        painter->drawImage(target, *image, source);
+        return true;
+    }
+    return false;
+}
 
-            // DEBUG
-            QString debugPath = QDir::temp().filePath("debug_teigha2.png");
-            m_cachedImage.save(debugPath);
-            qDebug() << "Debug image saved to:" << debugPath;
+const QImage& DwgRendererItem::tileSource(const DwgTileKey& key, const QImage& tile,
+                                         qreal devicePixelsPerTilePixel)
+{
+    if (devicePixelsPerTilePixel >= kMipThreshold)
+        return tile;
+
+    // Réduction 2:1 calculée une fois par tuile, à la première vue éloignée
+    if (const QImage* mip = m_mipTiles.object(key))
+        return *mip;
+    QImage* mip = new QImage(DwgPixelKernels::downsample2x(tile));
+    const int costKb = qMax<qsizetype>(1, mip->sizeInBytes() / 1024);
+    if (!m_mipTiles.insert(key, mip, costKb))
+        return tile;
+    return *m_mipTiles.object(key);
+}
 
-            m_imageGenerated = true;
+void DwgRendererItem::drawPrescaled(QPainter* painter, const DwgTileKey& key, const QImage& tile)
+{
+    // Bords arrondis au pixel : deux tuiles voisines partagent exactement leur bord
+    const QRectF mapped = painter->worldTransform().mapRect(m_tileGrid.tileRect(key));
+    const QRect target(QPoint(qRound(mapped.left()), qRound(mapped.top())),
+                       QPoint(qRound(mapped.right()) - 1, qRound(mapped.bottom()) - 1));
+    if (target.isEmpty())
+        return;
 
-            // Cleanup
-            SelectObject(hTempDC, hOldBitmap);
-            DeleteObject(hBitmap);
-            ReleaseDC(hTempWnd, hTempDC);
-            DestroyWindow(hTempWnd);
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    const QSize pixels = target.size() * dpr;
+    QPixmap* pixmap = m_scaledTiles.object(key);
+    if (!pixmap || pixmap->size() != pixels) {
+        // Rééchantillonnage lissé une seule fois par tuile et par zoom,
+        // depuis le mip quand la réduction dépasse son seuil
+        const QImage& source = tileSource(key, tile, qreal(pixels.width()) / tile.width());
+        pixmap = new QPixmap(QPixmap::fromImage(source.scaled(pixels, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+        pixmap->setDevicePixelRatio(dpr);
+        const int costKb = qMax(1, pixels.width() * pixels.height() * pixmap->depth() / 8 / 1024);
+        m_scaledTiles.insert(key, pixmap, costKb);
+        pixmap = m_scaledTiles.object(key);
+        if (!pixmap)
+            return;
+    }
 
-            return true;
-        }
+    painter->save();
+    painter->resetTransform();
+    painter->drawPixmap(target.topLeft(), *pixmap);
+    painter->restore();
+}
 
-    } catch (const OdError& e) {
-        qWarning() << "Generation error:" << QString::fromStdWString((const wchar_t*)e.description().c_str());
-    } catch (...) {
-        qWarning() << "Unknown generation error";
-    }
+bool DwgRendererItem::drawPreview(QPainter* painter, const QRectF& target)
+{
+    if (m_preview.isNull() || m_cachedBoundingRect.isEmpty())
+        return false;
 
-    // Cleanup en cas d'erreur
-    if (hOldBitmap && hTempDC) SelectObject(hTempDC, hOldBitmap);
-    if (hBitmap) DeleteObject(hBitmap);
-    if (hTempDC && hTempWnd) ReleaseDC(hTempWnd, hTempDC);
-    if (hTempWnd) DestroyWindow(hTempWnd);
+    const QRectF bounds = m_cachedBoundingRect;
+    const QRectF clipped = target.intersected(bounds);
+    if (clipped.isEmpty())
+        return false;
 
-    return false;
+    const qreal sx = m_preview.width() / bounds.width();
+    const qreal sy = m_preview.height() / bounds.height();
+    const QRectF source((clipped.left() - bounds.left()) * sx, (clipped.top() - bounds.top()) * sy,
+                        clipped.width() * sx, clipped.height() * sy);
+    painter->fillRect(target, Qt::white);
+    painter->drawImage(clipped, m_preview, source);
+    return true;
 }
 
-void DwgRendererItem::paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget* widget)
+void DwgRendererItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
-    if (m_pDb.isNull() || !widget) return;
-
-    if (!m_imageGenerated) {
-        if (!generateImage(widget->size())) {
-            // Fallback
-            painter->fillRect(widget->rect(), QColor(240, 240, 240));
-            painter->setPen(Qt::red);
-            painter->drawText(widget->rect(), Qt::AlignCenter, "Failed to render DWG");
-            return;
+    if (m_pDb.isNull()) return;
+
+    DWG_TRACE_SPAN("paint");
+    ensureExtentsValid();
+    if (m_tileGrid.isNull()) return;
+
+    // Niveau de la pyramide adapté à l'échelle d'affichage courante
+    const qreal scale = option->levelOfDetailFromTransform(painter->worldTransform())
+                        * painter->device()->devicePixelRatioF();
+    const int level = m_tileGrid.levelForScale(scale);
+    m_lastScale = scale / painter->device()->devicePixelRatioF();
+
+    // Mode vectoriel ou calques masqués : aucun rendu Teigha, seule la partie
+    // exposée des calques visibles est rejouée
+    if (usesDisplayList() && m_displayList) {
+        m_displayList->paint(painter, option->exposedRect, scale, m_hiddenLayerMask);
+        if (!m_firstFramePainted) {
+            m_firstFramePainted = true;
+            emit firstFramePainted();
+        }
+        return;
+    }
+
+    // Utiliser SmoothTransformation pour meilleur rendu au zoom
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    // Affichage : uniquement ce qui est déjà en cache
+    bool drewContent = false;
+    const QVector<DwgTileKey> keys = m_tileGrid.tilesIntersecting(option->exposedRect, level);
+    // Pré-mise à l'échelle : le cache ne vaut que pour un zoom sans rotation
+    const bool prescaled = m_prescaledTiles && painter->worldTransform().type() <= QTransform::TxScale;
+    if (prescaled && scale != m_prescaledScale) {
+        m_scaledTiles.clear();
+        m_prescaledScale = scale;
+    }
+
+    for (const DwgTileKey& key : keys) {
+        if (const QImage* tile = m_tiles.object(key)) {
+            if (prescaled)
+                drawPrescaled(painter, key, *tile);
+            else
+                painter->drawImage(m_tileGrid.tileRect(key),
+                                   tileSource(key, *tile, scale * m_tileGrid.tileRect(key).width() / tile->width()));
+            drewContent = true;
+        } else if (drawFallback(painter, key)) {
+            drewContent = true;
+        } else if (drawPreview(painter, m_tileGrid.tileRect(key))) {
+            // L'aperçu ne compte pas comme première image rendue
+        } else {
+            painter->fillRect(m_tileGrid.tileRect(key), QColor(240, 240, 240));
         }
     }
 
-    if (!m_cachedImage.isNull()) {
-        // Utiliser SmoothTransformation pour meilleur rendu au zoom
-        painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
-        painter->drawImage(widget->rect(), m_cachedImage);
+    if (drewContent && !m_firstFramePainted) {
+        m_firstFramePainted = true;
+        emit firstFramePainted();
+    }
+
+    // Planification : toutes les tuiles manquantes de la zone visible (et pas
+    // seulement de la zone exposée), pour que chaque demande remplace
+    // entièrement la précédente sans rien perdre
+    QRectF visible = option->exposedRect;
+    if (widget) {
+        bool invertible = false;
+        const QTransform toItem = painter->worldTransform().inverted(&invertible);
+        if (invertible)
+            visible = toItem.mapRect(QRectF(widget->rect()));
+    }
+
+    // Affichage progressif : la tuile racine (tout le dessin en basse
+    // résolution) sert de repli à toutes les autres, elle passe en premier
+    QVector<DwgTileKey> missing;
+    const DwgTileKey root;
+    if (needsRender(root))
+        missing.append(root);
+    for (const DwgTileKey& key : m_tileGrid.tilesIntersecting(visible, level)) {
+        if (needsRender(key) && key != root)
+            missing.append(key);
     }
+    m_worker->requestTiles(missing, visible.center());
 }
 
 void DwgRendererItem::wheelEvent(QGraphicsSceneWheelEvent* event)
@@ -354,3 +446,27 @@ void DwgRendererItem::wheelEvent(QGraphicsSceneWheelEvent* event)
     // On laisse passer l'événement au parent
     event->ignore();
 }
+
+void DwgRendererItem::setHoveredEntity(int index)
+{
+    if (index == m_hoveredEntity)
+        return;
+
+    m_hoveredEntity = index;
+    const QString description = m_index ? m_index->describe(index) : QString();
+    setToolTip(description);
+    emit entityHovered(description);
+}
+
+void DwgRendererItem::hoverMoveEvent(QGraphicsSceneHoverEvent* event)
+{
+    if (m_index && m_lastScale > 0.0)
+        setHoveredEntity(m_index->pick(event->pos(), kPickTolerancePx / m_lastScale));
+    QGraphicsObject::hoverMoveEvent(event);
+}
+
+void DwgRendererItem::hoverLeaveEvent(QGraphicsSceneHoverEvent* event)
+{
+    setHoveredEntity(-1);
+    QGraphicsObject::hoverLeaveEvent(event);
+}
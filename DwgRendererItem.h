@@ -5,13 +5,39 @@
 
 #include <QGraphicsObject>
 #include <QImage>
+#include <QPixmap>
 #include <QCursor>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+
+#include <memory>
+
+#include "DwgDisplayList.h"
+#include "DwgSpatialIndex.h"
+#include "DwgTileGrid.h"
 
 #include "DbDatabase.h"
 // #include "Gs/Gs.h"
 // #include "DbGsManager.h"
 // #include "GiContextForDbDatabase.h"
 
+class DwgRenderWorker;
+
+// Tuiles à jour d'un item, détachées de lui (images partagées, sans copie
+// des pixels) : reprises par un autre item sur la même base
+struct DwgTileSnapshot
+{
+    QRectF bounds;
+    DwgTileGrid grid;
+    QHash<DwgTileKey, QImage> tiles;
+    QHash<DwgTileKey, QImage> mipTiles;
+    QSet<DwgTileKey> staleTiles;        // Affichables, mais à rendre de nouveau
+    DwgSpatialIndexPtr index;
+};
+
+typedef std::shared_ptr<const DwgTileSnapshot> DwgTileSnapshotPtr;
+
 class DwgRendererItem : public QGraphicsObject
 {
     Q_OBJECT
@@ -23,21 +49,100 @@ public:
     QRectF boundingRect() const override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
+    // Mode vectoriel : rejoue la liste d'affichage au lieu des tuiles raster
+    // (les tuiles restent affichées tant que la liste n'est pas prête).
+    // La liste ne respecte pas DRAWORDER (voir DwgDisplayList)
+    void setVectorMode(bool enabled);
+    bool vectorMode() const { return m_vectorMode; }
+
+    // Visibilité d'un calque : appliquée à la composition de la liste
+    // d'affichage, sans nouvelle vectorisation. Les tuiles raster contiennent
+    // tous les calques, la liste d'affichage est donc utilisée dès qu'un
+    // calque est masqué, même hors mode vectoriel
+    void setLayerVisible(const QString& name, bool visible);
+
+    // Aperçu du fichier, étiré sur l'emprise : affiché là où aucune tuile
+    // (même plus grossière) n'est encore prête
+    void setPreview(const QImage& preview);
+
+    // Tuiles pré-mises à l'échelle de la vue (pixmaps copiés pixel pour
+    // pixel) : aucun rééchantillonnage par image tant que le zoom ne change pas
+    void setPrescaledTiles(bool enabled);
+
+    // Index spatial publié par le worker (nul tant qu'il n'est pas prêt)
+    DwgSpatialIndexPtr spatialIndex() const { return m_index; }
+    void setSpatialIndex(const DwgSpatialIndexPtr& index);
+
+    // Tuiles déjà rendues ; nul tant que la grille n'est pas connue
+    DwgTileSnapshotPtr tileSnapshot() const;
+
+    // Reprend la grille et les tuiles d'un instantané : version précédente du
+    // dessin (rechargement) ou présentation déjà affichée. Les tuiles qui
+    // touchent changedRegions (toutes si allChanged) restent affichées mais
+    // sont rendues à nouveau ; les autres ne sont plus jamais rendues.
+    // À appeler avant le premier paint()
+    void adoptTiles(const DwgTileSnapshot& previous, const QVector<QRectF>& changedRegions, bool allChanged);
+
+signals:
+    // Première image réellement affichée (mesure du temps d'ouverture)
+    void firstFramePainted();
+
+    // Entité sous le curseur (texte vide quand il n'y en a plus)
+    void entityHovered(const QString& description);
+
+private slots:
+    void onTileReady(const QRectF& gridBounds, const DwgTileKey& key, const QImage& image);
+    void onExtentsReady(const QRectF& bounds);
+    void onIndexReady(const DwgSpatialIndexPtr& index);
+    void onDisplayListReady(const DwgDisplayListPtr& displayList);
+
 protected:
     void wheelEvent(QGraphicsSceneWheelEvent *event) override;
+    void hoverMoveEvent(QGraphicsSceneHoverEvent *event) override;
+    void hoverLeaveEvent(QGraphicsSceneHoverEvent *event) override;
 
 private:
     OdDbDatabasePtr m_pDb;
     OdString m_gsDeviceModuleName;
 
-    QImage m_cachedImage;
-    bool m_imageGenerated = false;
+    // Pyramide de tuiles : seules les tuiles visibles au niveau courant sont rendues
+    mutable DwgTileGrid m_tileGrid;
+    QCache<DwgTileKey, QImage> m_tiles;
+    bool m_prescaledTiles = false;
+    qreal m_prescaledScale = 0.0;
+    QCache<DwgTileKey, QPixmap> m_scaledTiles;     // À l'échelle m_prescaledScale
+    QCache<DwgTileKey, QImage> m_mipTiles;          // Tuiles réduites de moitié
+    QSet<DwgTileKey> m_staleTiles;                  // Affichées en attendant leur nouveau rendu
+    std::unique_ptr<DwgRenderWorker> m_worker;
+
+    bool m_firstFramePainted = false;
+    QImage m_preview;
+
+    // Picking : index publié par le worker, échelle du dernier paint()
+    DwgSpatialIndexPtr m_index;
+    int m_hoveredEntity = -1;
+    qreal m_lastScale = 1.0;
+
+    bool m_vectorMode = false;
+    bool m_displayListRequested = false;
+    DwgDisplayListPtr m_displayList;
+
+    QSet<QString> m_hiddenLayers;
+    QVector<bool> m_hiddenLayerMask;    // Par indice de m_displayList->layerNames()
 
     mutable QRectF m_cachedBoundingRect;
     mutable bool m_bExtentsCalculated = false;
 
     void ensureExtentsValid() const;
-    bool generateImage(const QSize& size);
+    bool drawFallback(QPainter* painter, const DwgTileKey& key);
+    void drawPrescaled(QPainter* painter, const DwgTileKey& key, const QImage& tile);
+    const QImage& tileSource(const DwgTileKey& key, const QImage& tile, qreal devicePixelsPerTilePixel);
+    bool drawPreview(QPainter* painter, const QRectF& target);
+    void setHoveredEntity(int index);
+    void requestDisplayList();
+    void updateHiddenLayerMask();
+    bool needsRender(const DwgTileKey& key) const { return !m_tiles.contains(key) || m_staleTiles.contains(key); }
+    bool usesDisplayList() const { return m_vectorMode || !m_hiddenLayers.isEmpty(); }
 };
 
 #endif // DWGRENDERERITEM_H
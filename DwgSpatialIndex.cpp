@@ -0,0 +1,460 @@
+#include "DwgSpatialIndex.h"
+#include "DwgTrace.h"
+
+#include <QDebug>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "DbAttribute.h"
+#include "DbBlockReference.h"
+#include "DbBlockTable.h"
+#include "DbBlockTableRecord.h"
+#include "DbCurve.h"
+#include "DbDimStyleTableRecord.h"
+#include "DbEntity.h"
+#include "DbLayerTableRecord.h"
+#include "DbLinetypeTableRecord.h"
+#include "DbMText.h"
+#include "DbSymbolTable.h"
+#include "DbText.h"
+#include "DbTextStyleTableRecord.h"
+#include "Ge/GeExtents3d.h"
+
+// Nombre d'enfants par nœud : 16 boîtes tiennent dans quelques lignes de cache
+static const int kNodeCapacity = 16;
+
+DwgSpatialIndex::Box DwgSpatialIndex::Box::fromRect(const QRectF& rect)
+{
+    const QRectF r = rect.normalized();
+    Box box;
+    box.minX = r.left();
+    box.minY = r.top();
+    box.maxX = r.right();
+    box.maxY = r.bottom();
+    return box;
+}
+
+void DwgSpatialIndex::Box::unite(const Box& other)
+{
+    minX = qMin(minX, other.minX);
+    minY = qMin(minY, other.minY);
+    maxX = qMax(maxX, other.maxX);
+    maxY = qMax(maxY, other.maxY);
+}
+
+QRectF DwgSpatialIndex::bounds() const
+{
+    return m_root < 0 ? QRectF() : m_nodes.at(m_root).box.toRect();
+}
+
+template <typename Visitor>
+void DwgSpatialIndex::visit(const Box& box, Visitor visitor) const
+{
+    if (m_root < 0)
+        return;
+
+    // Parcours en profondeur sans récursion ; le visiteur renvoie false pour arrêter
+    QVarLengthArray<int, 64> stack;
+    stack.append(m_root);
+    while (!stack.isEmpty()) {
+        const Node& node = m_nodes.at(stack.takeLast());
+        if (!node.box.intersects(box))
+            continue;
+        if (node.leaf) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                if (m_entities.at(i).box.intersects(box) && !visitor(i))
+                    return;
+            }
+        } else {
+            for (int i = node.first; i < node.first + node.count; ++i)
+                stack.append(i);
+        }
+    }
+}
+
+bool DwgSpatialIndex::intersectsAny(const QRectF& rect) const
+{
+    bool found = false;
+    visit(Box::fromRect(rect), [&found](int) {
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+QVector<int> DwgSpatialIndex::query(const QRectF& rect) const
+{
+    QVector<int> result;
+    visit(Box::fromRect(rect), [&result](int index) {
+        result.append(index);
+        return true;
+    });
+    return result;
+}
+
+int DwgSpatialIndex::pick(const QPointF& point, qreal tolerance) const
+{
+    Box probe;
+    probe.minX = point.x() - tolerance;
+    probe.minY = point.y() - tolerance;
+    probe.maxX = point.x() + tolerance;
+    probe.maxY = point.y() + tolerance;
+
+    // Parmi les candidats, la plus petite emprise est la plus probable sous
+    // le curseur (un texte dans un cadre plutôt que le cadre)
+    int best = -1;
+    double bestSize = 0.0;
+    visit(probe, [&](int index) {
+        const Box& box = m_entities.at(index).box;
+        const double size = (box.maxX - box.minX) + (box.maxY - box.minY);
+        if (best < 0 || size < bestSize) {
+            best = index;
+            bestSize = size;
+        }
+        return true;
+    });
+    return best;
+}
+
+QString DwgSpatialIndex::describe(int index) const
+{
+    if (index < 0 || index >= m_entities.size())
+        return QString();
+
+    const Entity& e = m_entities.at(index);
+    const QString className = e.pClass
+        ? QString::fromWCharArray((const wchar_t*)e.pClass->name().c_str())
+        : QString("?");
+    const QString layer = e.layer >= 0 ? m_layerNames.at(e.layer) : QString("?");
+    return QString("%1 — calque %2 — handle %3")
+        .arg(className, layer, QString::number(e.handle, 16).toUpper());
+}
+
+QVector<QRectF> DwgSpatialIndex::changedRegions(const DwgSpatialIndex& before, const DwgSpatialIndex& after)
+{
+    // Fusion des deux listes triées par handle : O(n log n), sans table de hachage
+    auto byHandle = [](const DwgSpatialIndex& index) {
+        QVector<int> order(index.m_entities.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&index](int a, int b) {
+            return index.m_entities.at(a).handle < index.m_entities.at(b).handle;
+        });
+        return order;
+    };
+    const QVector<int> oldOrder = byHandle(before);
+    const QVector<int> newOrder = byHandle(after);
+
+    auto layerName = [](const DwgSpatialIndex& index, const Entity& e) {
+        return e.layer >= 0 ? index.m_layerNames.at(e.layer) : QString();
+    };
+
+    QVector<QRectF> regions;
+    int i = 0;
+    int j = 0;
+    while (i < oldOrder.size() || j < newOrder.size()) {
+        const Entity* pOld = i < oldOrder.size() ? &before.m_entities.at(oldOrder.at(i)) : nullptr;
+        const Entity* pNew = j < newOrder.size() ? &after.m_entities.at(newOrder.at(j)) : nullptr;
+        if (pNew && (!pOld || pNew->handle < pOld->handle)) {
+            regions.append(pNew->box.toRect());
+            ++j;
+        } else if (pOld && (!pNew || pOld->handle < pNew->handle)) {
+            regions.append(pOld->box.toRect());
+            ++i;
+        } else {
+            const bool sameBox = pOld->box.minX == pNew->box.minX && pOld->box.minY == pNew->box.minY
+                              && pOld->box.maxX == pNew->box.maxX && pOld->box.maxY == pNew->box.maxY;
+            if (!sameBox || pOld->pClass != pNew->pClass || pOld->properties != pNew->properties
+                || layerName(before, *pOld) != layerName(after, *pNew)) {
+                regions.append(pOld->box.toRect());
+                if (!sameBox)
+                    regions.append(pNew->box.toRect());
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return regions;
+}
+
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Sort-Tile-Recursive : tranches verticales triées en X, puis chaque
+// tranche triée en Y, et empaquetage par groupes de kNodeCapacity
+template <typename T, typename BoxOf>
+void strSort(QVector<T>& items, BoxOf boxOf)
+{
+    const int n = items.size();
+    const int leafCount = (n + kNodeCapacity - 1) / kNodeCapacity;
+    const int sliceCount = qMax(1, int(std::ceil(std::sqrt(double(leafCount)))));
+    const int sliceSize = sliceCount * kNodeCapacity;
+
+    auto centerX = [&](const T& t) { const DwgSpatialIndex::Box& b = boxOf(t); return b.minX + b.maxX; };
+    auto centerY = [&](const T& t) { const DwgSpatialIndex::Box& b = boxOf(t); return b.minY + b.maxY; };
+
+    std::sort(items.begin(), items.end(), [&](const T& a, const T& b) { return centerX(a) < centerX(b); });
+    for (int start = 0; start < n; start += sliceSize) {
+        const int end = qMin(n, start + sliceSize);
+        std::sort(items.begin() + start, items.begin() + end,
+                  [&](const T& a, const T& b) { return centerY(a) < centerY(b); });
+    }
+}
+
+uint hashText(const OdString& text, uint seed)
+{
+    return uint(qHashBits(text.c_str(), size_t(text.getLength()) * sizeof(OdChar), seed));
+}
+
+uint hashPoint(const OdGePoint3d& point, uint seed)
+{
+    return uint(qHashMulti(seed, point.x, point.y, point.z));
+}
+
+// Propriétés d'affichage qui ne changent pas forcément l'emprise : couleur,
+// type de ligne, épaisseur, extrémités des courbes et texte (valeurs
+// d'attributs comprises)
+uint propertyHash(const OdDbEntity* pEnt)
+{
+    uint hash = uint(qHashMulti(0, pEnt->color().color(), (OdUInt64)pEnt->linetypeId().getHandle(),
+                                int(pEnt->lineWeight())));
+    if (const OdDbCurve* pCurve = OdDbCurve::cast(pEnt).get()) {
+        OdGePoint3d start, end;
+        double endParam = 0.0;
+        if (pCurve->getStartPoint(start) == eOk && pCurve->getEndPoint(end) == eOk
+            && pCurve->getEndParam(endParam) == eOk)
+            hash = uint(qHashMulti(hashPoint(end, hashPoint(start, hash)), endParam));
+    }
+    if (const OdDbText* pText = OdDbText::cast(pEnt).get()) {
+        hash = hashText(pText->textString(), hash);
+    } else if (const OdDbMText* pMText = OdDbMText::cast(pEnt).get()) {
+        hash = hashText(pMText->contents(), hash);
+    } else if (const OdDbBlockReference* pRef = OdDbBlockReference::cast(pEnt).get()) {
+        for (OdDbObjectIteratorPtr pAttributes = pRef->attributeIterator(); !pAttributes->done(); pAttributes->step()) {
+            OdDbAttributePtr pAttribute = pAttributes->entity();
+            if (!pAttribute.isNull())
+                hash = hashText(pAttribute->textString(), hash);
+        }
+    }
+    return hash;
+}
+
+// Tout ce qui change l'aspect d'entités sans toucher leur propre
+// enregistrement : calques, types de ligne, styles de texte et de cote,
+// contenu des définitions de blocs (cotes comprises, via leurs blocs
+// anonymes) et variables d'affichage de l'en-tête
+uint definitionsHash(OdDbDatabase* pDb)
+{
+    uint hash = uint(qHashMulti(0, pDb->getLTSCALE(), int(pDb->getPDMODE()), pDb->getPDSIZE(),
+                                pDb->getFILLMODE()));
+
+    auto forEachRecord = [&](const OdDbObjectId& tableId, auto visitor) {
+        OdDbSymbolTablePtr pTable = tableId.safeOpenObject();
+        for (OdDbSymbolTableIteratorPtr pIter = pTable->newIterator(); !pIter->done(); pIter->step()) {
+            OdDbSymbolTableRecordPtr pRecord = pIter->getRecord();
+            if (pRecord.isNull())
+                continue;
+            hash = hashText(pRecord->getName(), hash);
+            visitor(pRecord.get());
+        }
+    };
+
+    forEachRecord(pDb->getLayerTableId(), [&](OdDbSymbolTableRecord* pRecord) {
+        const OdDbLayerTableRecord* pLayer = static_cast<const OdDbLayerTableRecord*>(pRecord);
+        hash = uint(qHashMulti(hash, pLayer->color().color(), (OdUInt64)pLayer->linetypeObjectId().getHandle(),
+                               int(pLayer->lineWeight()), pLayer->isOff(), pLayer->isFrozen()));
+    });
+    forEachRecord(pDb->getLinetypeTableId(), [&](OdDbSymbolTableRecord* pRecord) {
+        const OdDbLinetypeTableRecord* pLinetype = static_cast<const OdDbLinetypeTableRecord*>(pRecord);
+        hash = uint(qHashMulti(hash, pLinetype->patternLength(), pLinetype->numDashes()));
+        for (int i = 0; i < pLinetype->numDashes(); ++i)
+            hash = uint(qHashMulti(hash, pLinetype->dashLengthAt(i)));
+    });
+    forEachRecord(pDb->getTextStyleTableId(), [&](OdDbSymbolTableRecord* pRecord) {
+        const OdDbTextStyleTableRecord* pStyle = static_cast<const OdDbTextStyleTableRecord*>(pRecord);
+        hash = hashText(pStyle->fileName(), hash);
+        hash = hashText(pStyle->bigFontFileName(), hash);
+        hash = uint(qHashMulti(hash, pStyle->textSize(), pStyle->xScale(), pStyle->obliquingAngle()));
+    });
+    forEachRecord(pDb->getDimStyleTableId(), [&](OdDbSymbolTableRecord* pRecord) {
+        const OdDbDimStyleTableRecord* pStyle = static_cast<const OdDbDimStyleTableRecord*>(pRecord);
+        hash = uint(qHashMulti(hash, pStyle->dimscale(), pStyle->dimtxt(), pStyle->dimasz(), pStyle->dimgap(),
+                               pStyle->dimexe(), pStyle->dimexo(), int(pStyle->dimdec()),
+                               (OdUInt64)pStyle->dimtxsty().getHandle(), pStyle->dimclrd().color(),
+                               pStyle->dimclre().color(), pStyle->dimclrt().color()));
+    });
+
+    // Définitions de blocs : les espaces de présentation (espace objet
+    // compris) sont comparés entité par entité, les xrefs ne sont pas chargées
+    forEachRecord(pDb->getBlockTableId(), [&](OdDbSymbolTableRecord* pRecord) {
+        const OdDbBlockTableRecord* pBlock = static_cast<const OdDbBlockTableRecord*>(pRecord);
+        if (pBlock->isLayout() || pBlock->isFromExternalReference())
+            return;
+        for (OdDbObjectIteratorPtr pIter = pBlock->newIterator(); !pIter->done(); pIter->step()) {
+            OdDbEntityPtr pEnt = pIter->entity();
+            if (pEnt.isNull())
+                continue;
+            OdGeExtents3d extents;
+            if (pEnt->getGeomExtents(extents) == eOk && extents.isValidExtents())
+                hash = hashPoint(extents.maxPoint(), hashPoint(extents.minPoint(), hash));
+            hash = uint(qHashMulti(hash, (OdUInt64)pEnt->objectId().getHandle(), propertyHash(pEnt.get()),
+                                   (OdUInt64)pEnt->layerId().getHandle()));
+        }
+    });
+    return hash;
+}
+
+} // namespace
+
+DwgSpatialIndexBuilder::DwgSpatialIndexBuilder(OdDbDatabase* pDb)
+    : m_pDb(pDb)
+    , m_index(new DwgSpatialIndex())
+{
+    if (!m_pDb) {
+        m_done = m_skipped = true;
+        return;
+    }
+
+    try {
+        // En présentation, les entités visibles passent par les fenêtres de
+        // l'espace papier : les coordonnées ne correspondent plus, pas d'index
+        if (m_pDb->getActiveLayoutBTRId() != m_pDb->getModelSpaceId()) {
+            DwgTrace::counter("spatialIndexSkipped", 1);
+            m_done = m_skipped = true;
+            return;
+        }
+        OdDbBlockTableRecordPtr pModelSpace = m_pDb->getModelSpaceId().safeOpenObject();
+        m_pIter = pModelSpace->newIterator();
+    } catch (const OdError& e) {
+        qWarning() << "Spatial index:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+        m_done = m_skipped = true;
+    }
+}
+
+bool DwgSpatialIndexBuilder::step(int maxEntities)
+{
+    if (m_done)
+        return false;
+
+    try {
+        for (int i = 0; i < maxEntities && !m_pIter->done(); ++i, m_pIter->step()) {
+            OdDbEntityPtr pEnt = m_pIter->entity();
+            if (pEnt.isNull())
+                continue;
+
+            OdGeExtents3d extents;
+            if (pEnt->getGeomExtents(extents) != eOk || !extents.isValidExtents()) {
+                m_index->m_complete = false;
+                continue;
+            }
+
+            DwgSpatialIndex::Entity entity;
+            // Coordonnées item = coordonnées dessin avec l'axe Y inversé
+            entity.box.minX = extents.minPoint().x;
+            entity.box.maxX = extents.maxPoint().x;
+            entity.box.minY = -extents.maxPoint().y;
+            entity.box.maxY = -extents.minPoint().y;
+            entity.handle = (OdUInt64)pEnt->objectId().getHandle();
+            entity.pClass = pEnt->isA();
+            entity.properties = propertyHash(pEnt.get());
+
+            const OdDbObjectId layerId = pEnt->layerId();
+            OdDbStub* layerStub = (OdDbStub*)layerId;
+            auto it = m_layers.constFind(layerStub);
+            if (it == m_layers.constEnd()) {
+                OdDbLayerTableRecordPtr pLayer = layerId.openObject();
+                m_index->m_layerNames.append(pLayer.isNull()
+                    ? QString()
+                    : QString::fromWCharArray((const wchar_t*)pLayer->getName().c_str()));
+                it = m_layers.insert(layerStub, m_index->m_layerNames.size() - 1);
+            }
+            entity.layer = it.value();
+
+            m_index->m_entities.append(entity);
+        }
+        m_done = m_pIter->done();
+    } catch (const OdError& e) {
+        qWarning() << "Spatial index:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+        m_index->m_complete = false;
+        m_done = true;
+    }
+
+    if (m_done)
+        m_pIter.release();
+    return !m_done;
+}
+
+DwgSpatialIndexPtr DwgSpatialIndexBuilder::finish()
+{
+    while (step(4096)) {}
+    if (m_skipped)
+        return DwgSpatialIndexPtr();
+
+    DWG_TRACE_SPAN("spatialIndexFinish");
+    std::unique_ptr<DwgSpatialIndex> index = std::move(m_index);
+    m_index.reset(new DwgSpatialIndex());
+    m_layers.clear();
+
+    try {
+        index->m_definitionsHash = definitionsHash(m_pDb);
+    } catch (const OdError& e) {
+        // Définitions illisibles : l'index ne peut plus garantir une comparaison locale
+        qWarning() << "Spatial index definitions:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+        index->m_complete = false;
+    }
+
+    typedef DwgSpatialIndex::Node Node;
+    typedef DwgSpatialIndex::Entity Entity;
+
+    QVector<Entity>& entities = index->m_entities;
+    if (entities.isEmpty())
+        return DwgSpatialIndexPtr(index.release());
+    entities.squeeze();
+
+    // Feuilles : les entités triées sont regroupées sur place
+    strSort(entities, [](const Entity& e) -> const DwgSpatialIndex::Box& { return e.box; });
+    QVector<Node> level;
+    level.reserve((entities.size() + kNodeCapacity - 1) / kNodeCapacity);
+    for (int start = 0; start < entities.size(); start += kNodeCapacity) {
+        Node node;
+        node.leaf = true;
+        node.first = start;
+        node.count = qMin(kNodeCapacity, int(entities.size()) - start);
+        node.box = entities.at(start).box;
+        for (int i = start + 1; i < start + node.count; ++i)
+            node.box.unite(entities.at(i).box);
+        level.append(node);
+    }
+
+    // Niveaux supérieurs : chaque niveau trié est ajouté d'un bloc à
+    // m_nodes, ses parents pointent sur des plages contiguës
+    QVector<Node>& nodes = index->m_nodes;
+    while (level.size() > 1) {
+        strSort(level, [](const Node& n) -> const DwgSpatialIndex::Box& { return n.box; });
+        const int base = nodes.size();
+        nodes += level;
+
+        QVector<Node> parents;
+        parents.reserve((level.size() + kNodeCapacity - 1) / kNodeCapacity);
+        for (int start = 0; start < level.size(); start += kNodeCapacity) {
+            Node node;
+            node.first = base + start;
+            node.count = qMin(kNodeCapacity, int(level.size()) - start);
+            node.box = level.at(start).box;
+            for (int i = start + 1; i < start + node.count; ++i)
+                node.box.unite(level.at(i).box);
+            parents.append(node);
+        }
+        level.swap(parents);
+    }
+    nodes += level;
+    nodes.squeeze();
+    index->m_root = nodes.size() - 1;
+
+    DwgTrace::counter("spatialIndexEntities", entities.size());
+    DwgTrace::counter("spatialIndexNodes", nodes.size());
+    return DwgSpatialIndexPtr(index.release());
+}
@@ -0,0 +1,141 @@
+#include "OdaCommon.h"
+
+#ifndef DWGSPATIALINDEX_H
+#define DWGSPATIALINDEX_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+#include "DbDatabase.h"
+#include "DbObjectIterator.h"
+
+// R-tree en lecture seule sur les emprises des entités de l'espace objet,
+// chargé en bloc (Sort-Tile-Recursive) : nœuds contigus, aucune allocation
+// par entité. Une fois construit il est immuable, donc partageable sans verrou
+// entre le thread de rendu et le thread GUI.
+// Les rectangles sont en coordonnées item (Y dessin inversé).
+class DwgSpatialIndex
+{
+public:
+    // Boîte fermée : contrairement à QRectF, une ligne horizontale ou
+    // verticale (largeur ou hauteur nulle) reste une boîte valide
+    struct Box
+    {
+        double minX = 0.0;
+        double minY = 0.0;
+        double maxX = 0.0;
+        double maxY = 0.0;
+
+        static Box fromRect(const QRectF& rect);
+        QRectF toRect() const { return QRectF(minX, minY, maxX - minX, maxY - minY); }
+        bool intersects(const Box& other) const
+        {
+            return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+        }
+        void unite(const Box& other);
+    };
+
+    struct Entity
+    {
+        Box box;
+        OdUInt64 handle = 0;
+        const OdRxClass* pClass = nullptr;
+        int layer = -1;                     // Indice dans layerNames()
+        uint properties = 0;                // Empreinte couleur, type de ligne, épaisseur, texte
+    };
+
+    int size() const { return m_entities.size(); }
+    bool isEmpty() const { return m_entities.isEmpty(); }
+    QRectF bounds() const;
+
+    // Toutes les entités ont une emprise (aucune droite infinie, aucune
+    // emprise invalide) : une zone sans résultat est réellement vide
+    bool isComplete() const { return m_complete; }
+
+    // Empreinte des tables de symboles, des définitions de blocs et des
+    // variables d'affichage : deux versions dont l'empreinte diffère ne se
+    // comparent pas entité par entité (changedRegions ne voit pas un calque
+    // recoloré ni un bloc redessiné)
+    uint definitionsHash() const { return m_definitionsHash; }
+
+    // Au moins une entité touche le rectangle (court-circuite au premier trouvé)
+    bool intersectsAny(const QRectF& rect) const;
+
+    // Indices des entités dont l'emprise touche le rectangle
+    QVector<int> query(const QRectF& rect) const;
+
+    // Entité la plus petite dont l'emprise contient le point à la tolérance près, -1 sinon
+    int pick(const QPointF& point, qreal tolerance) const;
+
+    const Entity& entity(int index) const { return m_entities.at(index); }
+    const QStringList& layerNames() const { return m_layerNames; }
+
+    // Texte court pour l'info-bulle / la barre d'état : type, calque, handle
+    QString describe(int index) const;
+
+    // Emprises touchées entre deux versions d'un même dessin, appariées par
+    // handle : entités ajoutées, supprimées, ou dont l'emprise, le type, le
+    // calque ou l'empreinte des propriétés a changé (ancienne et nouvelle
+    // emprise). Les entités sans emprise n'y figurent pas : avec un index
+    // incomplet, ou des definitionsHash() différents, l'appelant doit tout
+    // considérer comme modifié
+    static QVector<QRectF> changedRegions(const DwgSpatialIndex& before, const DwgSpatialIndex& after);
+
+private:
+    friend class DwgSpatialIndexBuilder;
+
+    struct Node
+    {
+        Box box;
+        int first = 0;      // Premier enfant (nœud, ou entité pour une feuille)
+        int count = 0;
+        bool leaf = false;
+    };
+
+    template <typename Visitor>
+    void visit(const Box& box, Visitor visitor) const;
+
+    QVector<Entity> m_entities;
+    QVector<Node> m_nodes;
+    int m_root = -1;
+    bool m_complete = true;
+    uint m_definitionsHash = 0;
+    QStringList m_layerNames;
+};
+
+typedef std::shared_ptr<const DwgSpatialIndex> DwgSpatialIndexPtr;
+Q_DECLARE_METATYPE(DwgSpatialIndexPtr)
+
+// Construction incrémentale : le parcours de l'espace objet se fait par
+// tranches (step) pour que le thread de rendu puisse intercaler des tuiles.
+// À utiliser depuis un seul thread, celui qui accède à la base.
+class DwgSpatialIndexBuilder
+{
+public:
+    explicit DwgSpatialIndexBuilder(OdDbDatabase* pDb);
+
+    // Indexe au plus maxEntities entités ; renvoie false quand le parcours est terminé
+    bool step(int maxEntities);
+    bool isDone() const { return m_done; }
+
+    // Trie et empaquette l'arbre ; le builder est vide ensuite.
+    // Nul si l'index ne s'applique pas (présentation active)
+    DwgSpatialIndexPtr finish();
+
+private:
+    OdDbDatabase* m_pDb;
+    OdDbObjectIteratorPtr m_pIter;
+    bool m_done = false;
+    bool m_skipped = false;
+    std::unique_ptr<DwgSpatialIndex> m_index;
+    QHash<OdDbStub*, int> m_layers;
+};
+
+#endif // DWGSPATIALINDEX_H
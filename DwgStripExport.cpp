@@ -0,0 +1,184 @@
+#include "DwgStripExport.h"
+#include "DwgOffscreenRenderer.h"
+#include "DwgTiffWriter.h"
+#include "DwgTrace.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <memory>
+
+namespace {
+
+// Bandes rendues en attente d'encodage : une seule, le rendu attend
+// l'encodeur au-delà (mémoire bornée)
+const int kMaxQueuedBands = 1;
+
+const qreal kMmPerInch = 25.4;
+
+// File entre le rendu (producteur) et l'encodage (consommateur)
+struct BandQueue
+{
+    QMutex mutex;
+    QWaitCondition changed;
+    QQueue<QImage> bands;
+    bool finished = false;      // Plus aucune bande à venir
+    bool failed = false;        // Erreur d'écriture : le rendu s'arrête
+};
+
+} // namespace
+
+namespace DwgStripExport
+{
+
+DwgStripExportResult exportTiff(OdDbDatabasePtr pDb, const QString& path, const DwgStripExportSettings& settings,
+                                const std::function<void(int)>& progress, const std::atomic<bool>* pAbort)
+{
+    DwgStripExportResult result;
+    if (pDb.isNull() || settings.region.isEmpty() || settings.size.isEmpty()) {
+        result.error = "Paramètres d'export invalides";
+        return result;
+    }
+
+    DWG_TRACE_SPAN("stripExport");
+    QElapsedTimer total;
+    total.start();
+
+    DwgTiffWriter writer;
+    if (!writer.open(path, settings.size, settings.dpi)) {
+        result.error = writer.errorString();
+        return result;
+    }
+
+    const int width = settings.size.width();
+    const int height = settings.size.height();
+    const int bandHeight = qBound(1, settings.bandHeight, height);
+    const qreal unitsPerRow = settings.region.height() / height;
+
+    // Encodage de la bande N pendant le rendu de la bande N + 1
+    BandQueue queue;
+    qint64 encodeNs = 0;
+    std::unique_ptr<QThread> encoder(QThread::create([&]() {
+        QElapsedTimer timer;
+        int rowsDone = 0;
+        for (;;) {
+            QImage band;
+            {
+                QMutexLocker lock(&queue.mutex);
+                while (queue.bands.isEmpty() && !queue.finished)
+                    queue.changed.wait(&queue.mutex);
+                if (queue.bands.isEmpty())
+                    break;
+                band = queue.bands.dequeue();
+                queue.changed.wakeAll();
+            }
+
+            timer.start();
+            const bool written = writer.writeRows(band);
+            encodeNs += timer.nsecsElapsed();
+            if (!written) {
+                QMutexLocker lock(&queue.mutex);
+                queue.failed = true;
+                queue.bands.clear();
+                queue.changed.wakeAll();
+                break;
+            }
+            rowsDone += band.height();
+            if (progress)
+                progress(int(qint64(rowsDone) * 100 / height));
+        }
+    }));
+    encoder->setObjectName("DwgStripExport encoder");
+    encoder->start();
+
+    QElapsedTimer renderTimer;
+    renderTimer.start();
+    bool rendered = true;
+    {
+        // Un seul device pour toutes les bandes : le cache GS sert d'une bande à l'autre
+        DwgOffscreenRenderer renderer(pDb);
+        renderer.setAbortFlag(pAbort);
+
+        for (int y = 0; y < height && rendered; y += bandHeight) {
+            const int rows = qMin(bandHeight, height - y);
+            // Même échelle pour toutes les bandes : les bords se raccordent au pixel près
+            const QRectF band(settings.region.left(), settings.region.top() + y * unitsPerRow,
+                              settings.region.width(), rows * unitsPerRow);
+            QImage image;
+            if (!renderer.render(band, QSize(width, rows), image) || (pAbort && *pAbort)) {
+                rendered = false;
+                break;
+            }
+            ++result.bands;
+
+            QMutexLocker lock(&queue.mutex);
+            while (queue.bands.size() >= kMaxQueuedBands && !queue.failed)
+                queue.changed.wait(&queue.mutex);
+            if (queue.failed)
+                break;
+            queue.bands.enqueue(image);
+            queue.changed.wakeAll();
+        }
+    }
+    {
+        QMutexLocker lock(&queue.mutex);
+        queue.finished = true;
+        if (!rendered)
+            queue.bands.clear();
+        queue.changed.wakeAll();
+    }
+    encoder->wait();
+    result.renderMs = renderTimer.elapsed();
+    result.encodeMs = encodeNs / 1000000;
+
+    if (!rendered) {
+        writer.close();
+        result.error = pAbort && *pAbort ? QString("Export annulé") : QString("Échec du rendu d'une bande");
+    } else if (queue.failed) {
+        result.error = writer.errorString();
+        writer.close();
+    } else if (!writer.close()) {
+        result.error = writer.errorString();
+    } else {
+        result.ok = true;
+    }
+    // Pas de fichier tronqué laissé derrière un échec
+    if (!result.ok)
+        QFile::remove(path);
+    result.bytes = writer.bytesWritten();
+    result.bigTiff = writer.isBigTiff();
+    result.totalMs = total.elapsed();
+    return result;
+}
+
+QSizeF paperSizeMm(const QString& paper)
+{
+    const QString name = paper.trimmed().toUpper();
+    if (name == "A0") return QSizeF(841, 1189);
+    if (name == "A1") return QSizeF(594, 841);
+    if (name == "A2") return QSizeF(420, 594);
+    if (name == "A3") return QSizeF(297, 420);
+    if (name == "A4") return QSizeF(210, 297);
+    return QSizeF();
+}
+
+QSize fitToPaper(const QRectF& region, const QSizeF& paperMm, qreal dpi)
+{
+    if (region.isEmpty() || paperMm.isEmpty() || dpi <= 0.0)
+        return QSize();
+
+    // Feuille dans le sens du dessin, puis dessin ajusté à la feuille
+    QSizeF paper = paperMm * (dpi / kMmPerInch);
+    if ((region.width() > region.height()) != (paper.width() > paper.height()))
+        paper.transpose();
+    const QSizeF fitted = region.size().scaled(paper, Qt::KeepAspectRatio);
+    return QSize(qMax(1, qRound(fitted.width())), qMax(1, qRound(fitted.height())));
+}
+
+} // namespace DwgStripExport
@@ -0,0 +1,57 @@
+#include "OdaCommon.h"
+
+#ifndef DWGSTRIPEXPORT_H
+#define DWGSTRIPEXPORT_H
+
+#include <QRectF>
+#include <QSize>
+#include <QSizeF>
+#include <QString>
+
+#include <atomic>
+#include <functional>
+
+#include "DbDatabase.h"
+
+struct DwgStripExportSettings
+{
+    QRectF region;          // Coordonnées item (Y inversé)
+    QSize size;             // Pixels de l'image complète
+    qreal dpi = 0.0;        // Résolution enregistrée dans le fichier (0 : aucune)
+    int bandHeight = 512;   // Lignes rendues par passe du device
+};
+
+struct DwgStripExportResult
+{
+    bool ok = false;
+    QString error;
+    int bands = 0;
+    qint64 renderMs = 0;    // Rendu des bandes (thread appelant)
+    qint64 encodeMs = 0;    // Compression et écriture, en parallèle du rendu
+    qint64 totalMs = 0;
+    qint64 bytes = 0;
+    bool bigTiff = false;
+};
+
+// Export raster grand format (traceur) sans image complète en mémoire : le
+// dessin est rendu en bandes horizontales par le device bitmap hors écran,
+// et chaque bande part vers DwgTiffWriter sur un thread d'encodage pendant
+// que la suivante est rendue. La mémoire crête dépend de la largeur et de
+// bandHeight (quelques bandes), pas de la hauteur de l'image.
+// Le thread appelant doit être déclaré à Teigha (DwgThreadScope) et la base
+// en mode multithread si d'autres threads la lisent.
+namespace DwgStripExport
+{
+    // progress(pourcentage) est appelé depuis le thread d'encodage
+    DwgStripExportResult exportTiff(OdDbDatabasePtr pDb, const QString& path, const DwgStripExportSettings& settings,
+                                    const std::function<void(int)>& progress = std::function<void(int)>(),
+                                    const std::atomic<bool>* pAbort = nullptr);
+
+    // Feuilles ISO A0 à A4 : taille en millimètres, portrait ; vide si inconnue
+    QSizeF paperSizeMm(const QString& paper);
+
+    // Image d'une feuille à une résolution, orientée et ajustée aux proportions de region
+    QSize fitToPaper(const QRectF& region, const QSizeF& paperMm, qreal dpi);
+}
+
+#endif // DWGSTRIPEXPORT_H
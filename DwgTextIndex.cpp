@@ -0,0 +1,246 @@
+#include "DwgTextIndex.h"
+#include "DwgTrace.h"
+
+#include <QDebug>
+#include <QHash>
+
+#include <algorithm>
+
+#include "DbAttribute.h"
+#include "DbAttributeDefinition.h"
+#include "DbBlockReference.h"
+#include "DbBlockTableRecord.h"
+#include "DbLayerTableRecord.h"
+#include "DbMText.h"
+#include "DbText.h"
+#include "Ge/GeExtents3d.h"
+
+namespace {
+
+// Entités parcourues entre deux lectures du drapeau d'interruption
+const int kAbortCheckInterval = 256;
+
+// Trois unités UTF-16 consécutives sur 48 bits
+quint64 trigramAt(QStringView text, int i)
+{
+    return (quint64(text.at(i).unicode()) << 32) | (quint64(text.at(i + 1).unicode()) << 16)
+           | quint64(text.at(i + 2).unicode());
+}
+
+QString foldCase(const QString& text)
+{
+    // Les arènes partagent leurs positions : le repli doit garder la longueur
+    const QString folded = text.toCaseFolded();
+    return folded.size() == text.size() ? folded : text;
+}
+
+} // namespace
+
+QStringView DwgTextIndex::foldedView(int index) const
+{
+    const Entry& e = m_entries.at(index);
+    return QStringView(m_folded).mid(e.offset, e.length);
+}
+
+QString DwgTextIndex::text(int index) const
+{
+    const Entry& e = m_entries.at(index);
+    return m_text.mid(e.offset, e.length);
+}
+
+QString DwgTextIndex::layerName(int index) const
+{
+    const int layer = m_entries.at(index).layer;
+    return layer >= 0 ? m_layerNames.at(layer) : QString();
+}
+
+QVector<int> DwgTextIndex::find(const QString& query, int maxResults) const
+{
+    QVector<int> results;
+    const QString needle = foldCase(query.simplified());
+    if (needle.isEmpty() || maxResults <= 0)
+        return results;
+
+    // Préfixes : plage contiguë de l'ordre trié
+    auto first = std::lower_bound(m_sorted.cbegin(), m_sorted.cend(), needle,
+                                  [this](quint32 entry, const QString& value) {
+                                      return foldedView(int(entry)).compare(value) < 0;
+                                  });
+    for (auto it = first; it != m_sorted.cend() && results.size() < maxResults; ++it) {
+        if (!foldedView(int(*it)).startsWith(needle))
+            break;
+        results.append(int(*it));
+    }
+    if (results.size() >= maxResults)
+        return results;
+
+    // Puis les textes qui contiennent la requête ailleurs qu'en tête
+    auto containsInside = [&](int entry) {
+        const QStringView text = foldedView(entry);
+        return !text.startsWith(needle) && text.indexOf(needle, 1) >= 0;
+    };
+    if (needle.size() < 3) {
+        // Trop court pour les trigrammes : parcours de toutes les entrées
+        for (int i = 0; i < m_entries.size() && results.size() < maxResults; ++i) {
+            if (containsInside(i))
+                results.append(i);
+        }
+        return results;
+    }
+
+    // Liste de trigrammes la plus courte ; chaque candidat est vérifié sur le texte
+    int best = -1;
+    for (int i = 0; i + 3 <= needle.size(); ++i) {
+        const quint64 trigram = trigramAt(needle, i);
+        const auto it = std::lower_bound(m_trigrams.cbegin(), m_trigrams.cend(), trigram);
+        if (it == m_trigrams.cend() || *it != trigram)
+            return results;     // Aucun texte ne contient ce trigramme
+        const int t = int(it - m_trigrams.cbegin());
+        if (best < 0 || m_postingStart.at(t + 1) - m_postingStart.at(t)
+                            < m_postingStart.at(best + 1) - m_postingStart.at(best))
+            best = t;
+    }
+    for (quint32 p = m_postingStart.at(best); p < m_postingStart.at(best + 1) && results.size() < maxResults; ++p) {
+        if (containsInside(int(m_postings.at(p))))
+            results.append(int(m_postings.at(p)));
+    }
+    return results;
+}
+
+void DwgTextIndex::addText(const QString& text, OdUInt64 handle, int layer, const DwgSpatialIndex::Box& box)
+{
+    Entry entry;
+    entry.offset = quint32(m_text.size());
+    entry.length = quint32(text.size());
+    entry.handle = handle;
+    entry.layer = layer;
+    entry.box = box;
+    m_entries.append(entry);
+    m_text += text;
+    m_folded += foldCase(text);
+}
+
+void DwgTextIndex::buildSearchStructures()
+{
+    m_entries.squeeze();
+    m_text.squeeze();
+    m_folded.squeeze();
+
+    m_sorted.resize(m_entries.size());
+    for (int i = 0; i < m_entries.size(); ++i)
+        m_sorted[i] = quint32(i);
+    std::sort(m_sorted.begin(), m_sorted.end(), [this](quint32 a, quint32 b) {
+        return foldedView(int(a)).compare(foldedView(int(b))) < 0;
+    });
+
+    // Paires (trigramme, entrée) triées puis compactées en listes par trigramme
+    struct Posting
+    {
+        quint64 trigram;
+        quint32 entry;
+        bool operator<(const Posting& other) const
+        {
+            return trigram != other.trigram ? trigram < other.trigram : entry < other.entry;
+        }
+        bool operator==(const Posting& other) const { return trigram == other.trigram && entry == other.entry; }
+    };
+    QVector<Posting> postings;
+    postings.reserve(qMax(0, int(m_folded.size()) - 2 * int(m_entries.size())));
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const QStringView text = foldedView(i);
+        for (int j = 0; j + 3 <= text.size(); ++j)
+            postings.append({ trigramAt(text, j), quint32(i) });
+    }
+    std::sort(postings.begin(), postings.end());
+    postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+
+    m_postings.reserve(postings.size());
+    for (const Posting& posting : postings) {
+        if (m_trigrams.isEmpty() || m_trigrams.constLast() != posting.trigram) {
+            m_trigrams.append(posting.trigram);
+            m_postingStart.append(quint32(m_postings.size()));
+        }
+        m_postings.append(posting.entry);
+    }
+    m_postingStart.append(quint32(m_postings.size()));
+    m_trigrams.squeeze();
+    m_postingStart.squeeze();
+}
+
+DwgTextIndexPtr DwgTextIndex::build(OdDbDatabase* pDb, const std::atomic<bool>* pAbort)
+{
+    if (!pDb)
+        return DwgTextIndexPtr();
+
+    DWG_TRACE_SPAN("textIndex");
+
+    std::unique_ptr<DwgTextIndex> index(new DwgTextIndex());
+    QHash<OdDbStub*, int> layers;
+    auto add = [&](const OdDbEntity* pEnt, const OdString& value) {
+        const QString text = QString::fromWCharArray((const wchar_t*)value.c_str()).simplified();
+        if (text.isEmpty())
+            return;
+
+        // Un texte sans emprise ne peut pas être cadré : il n'est pas indexé
+        OdGeExtents3d extents;
+        if (pEnt->getGeomExtents(extents) != eOk || !extents.isValidExtents())
+            return;
+        DwgSpatialIndex::Box box;
+        box.minX = extents.minPoint().x;
+        box.maxX = extents.maxPoint().x;
+        box.minY = -extents.maxPoint().y;
+        box.maxY = -extents.minPoint().y;
+
+        const OdDbObjectId layerId = pEnt->layerId();
+        OdDbStub* layerStub = (OdDbStub*)layerId;
+        auto it = layers.constFind(layerStub);
+        if (it == layers.constEnd()) {
+            OdDbLayerTableRecordPtr pLayer = layerId.openObject();
+            index->m_layerNames.append(pLayer.isNull()
+                ? QString()
+                : QString::fromWCharArray((const wchar_t*)pLayer->getName().c_str()));
+            it = layers.insert(layerStub, index->m_layerNames.size() - 1);
+        }
+        index->addText(text, (OdUInt64)pEnt->objectId().getHandle(), it.value(), box);
+    };
+
+    try {
+        // Espace de la présentation active : les emprises sont celles de l'affichage
+        OdDbBlockTableRecordPtr pSpace = pDb->getActiveLayoutBTRId().safeOpenObject();
+        int visited = 0;
+        for (OdDbObjectIteratorPtr pIter = pSpace->newIterator(); !pIter->done(); pIter->step()) {
+            if (++visited % kAbortCheckInterval == 0 && pAbort && *pAbort)
+                return DwgTextIndexPtr();
+
+            OdDbEntityPtr pEnt = pIter->entity();
+            // Une définition d'attribut porte une étiquette, pas une valeur
+            if (pEnt.isNull() || pEnt->isKindOf(OdDbAttributeDefinition::desc()))
+                continue;
+
+            if (OdDbText* pText = OdDbText::cast(pEnt).get()) {
+                add(pText, pText->textString());
+            } else if (OdDbMText* pMText = OdDbMText::cast(pEnt).get()) {
+                // Texte sans codes de mise en forme
+                add(pMText, pMText->text());
+            } else if (OdDbBlockReference* pRef = OdDbBlockReference::cast(pEnt).get()) {
+                for (OdDbObjectIteratorPtr pAttributes = pRef->attributeIterator(); !pAttributes->done();
+                     pAttributes->step()) {
+                    OdDbAttributePtr pAttribute = pAttributes->entity();
+                    if (!pAttribute.isNull() && !pAttribute->isInvisible())
+                        add(pAttribute, pAttribute->textString());
+                }
+            }
+        }
+    } catch (const OdError& e) {
+        qWarning() << "Text index:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+    }
+
+    index->buildSearchStructures();
+    const qint64 bytes = qint64(index->m_text.size() + index->m_folded.size()) * qint64(sizeof(QChar))
+                         + qint64(index->m_entries.size()) * qint64(sizeof(Entry))
+                         + qint64(index->m_postings.size() + index->m_sorted.size()) * qint64(sizeof(quint32))
+                         + qint64(index->m_trigrams.size()) * qint64(sizeof(quint64) + sizeof(quint32));
+    DwgTrace::counter("textIndexTexts", index->size());
+    DwgTrace::counter("textIndexKb", bytes / 1024);
+    return DwgTextIndexPtr(index.release());
+}
@@ -0,0 +1,75 @@
+#include "OdaCommon.h"
+
+#ifndef DWGTEXTINDEX_H
+#define DWGTEXTINDEX_H
+
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "DbDatabase.h"
+
+#include "DwgSpatialIndex.h"
+
+// Index en mémoire des textes de la présentation active : TEXT, MTEXT et
+// valeurs visibles des attributs de blocs, avec handle, calque et emprise.
+// Les chaînes sont rangées bout à bout dans deux arènes (texte d'origine et
+// texte replié en casse, mêmes positions) ; la recherche passe par un ordre
+// trié pour les préfixes et par des listes de trigrammes pour les
+// sous-chaînes. Immuable une fois construit, partageable sans verrou.
+// Les emprises sont en coordonnées item (Y dessin inversé).
+class DwgTextIndex
+{
+public:
+    int size() const { return m_entries.size(); }
+
+    // Textes qui commencent par query (en premier) puis qui le contiennent,
+    // sans distinction de casse ; au plus maxResults indices
+    QVector<int> find(const QString& query, int maxResults) const;
+
+    QString text(int index) const;
+    OdUInt64 handle(int index) const { return m_entries.at(index).handle; }
+    QString layerName(int index) const;
+    QRectF rect(int index) const { return m_entries.at(index).box.toRect(); }
+
+    // Parcourt l'espace de la présentation active ; nul si interrompu.
+    // Le thread appelant doit pouvoir lire la base (DwgThreadScope, mode
+    // multithread si d'autres threads la lisent)
+    static std::shared_ptr<const DwgTextIndex> build(OdDbDatabase* pDb, const std::atomic<bool>* pAbort);
+
+private:
+    struct Entry
+    {
+        quint32 offset = 0;         // Dans m_text et m_folded
+        quint32 length = 0;
+        OdUInt64 handle = 0;
+        int layer = -1;             // Indice dans m_layerNames
+        DwgSpatialIndex::Box box;
+    };
+
+    QStringView foldedView(int index) const;
+    void addText(const QString& text, OdUInt64 handle, int layer, const DwgSpatialIndex::Box& box);
+    void buildSearchStructures();
+
+    QVector<Entry> m_entries;
+    QString m_text;
+    QString m_folded;
+    QStringList m_layerNames;
+
+    // Entrées triées par texte replié (recherche de préfixe par dichotomie)
+    QVector<quint32> m_sorted;
+
+    // Trigrammes triés ; les entrées qui contiennent m_trigrams[i] sont
+    // m_postings[m_postingStart[i] .. m_postingStart[i + 1]), par indice croissant
+    QVector<quint64> m_trigrams;
+    QVector<quint32> m_postingStart;
+    QVector<quint32> m_postings;
+};
+
+typedef std::shared_ptr<const DwgTextIndex> DwgTextIndexPtr;
+
+#endif // DWGTEXTINDEX_H
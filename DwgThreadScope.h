@@ -0,0 +1,81 @@
+#include "OdaCommon.h"
+
+#ifndef DWGTHREADSCOPE_H
+#define DWGTHREADSCOPE_H
+
+#include "OdMutex.h"
+#include "ThreadsCounter.h"
+#include "DbDatabase.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+// Déclare le thread courant à Teigha pour la durée de la portée.
+// Nécessaire dès que plusieurs threads lisent ou vectorisent en parallèle :
+// Teigha bascule alors ses verrous internes en mode multithread.
+class DwgThreadScope
+{
+public:
+    DwgThreadScope()
+        : m_threadId(odGetCurrentThreadId())
+    {
+        odThreadsCounter().startThreads(1, &m_threadId, ThreadsCounter::kAllAttributes);
+    }
+
+    ~DwgThreadScope()
+    {
+        odThreadsCounter().stopThreads(1, &m_threadId);
+    }
+
+    DwgThreadScope(const DwgThreadScope&) = delete;
+    DwgThreadScope& operator=(const DwgThreadScope&) = delete;
+
+private:
+    unsigned m_threadId;
+};
+
+// Mode rendu multithread de Teigha sur une base, partagé entre ses
+// utilisateurs (threads de tuiles, vignettes des présentations) : activé par
+// le premier, rétabli en monothread par le dernier. À créer et détruire
+// quand aucun thread ne lit la base.
+class DwgMultiThreadedMode
+{
+public:
+    explicit DwgMultiThreadedMode(OdDbDatabase* pDb)
+        : m_pDb(pDb)
+    {
+        QMutexLocker lock(&mutex());
+        if (users()[m_pDb]++ == 0)
+            m_pDb->setMultiThreadedMode(OdDb::kMTRendering);
+    }
+
+    ~DwgMultiThreadedMode()
+    {
+        QMutexLocker lock(&mutex());
+        if (--users()[m_pDb] == 0) {
+            users().remove(m_pDb);
+            m_pDb->setMultiThreadedMode(OdDb::kSTMode);
+        }
+    }
+
+    DwgMultiThreadedMode(const DwgMultiThreadedMode&) = delete;
+    DwgMultiThreadedMode& operator=(const DwgMultiThreadedMode&) = delete;
+
+private:
+    static QMutex& mutex()
+    {
+        static QMutex s_mutex;
+        return s_mutex;
+    }
+
+    static QHash<OdDbDatabase*, int>& users()
+    {
+        static QHash<OdDbDatabase*, int> s_users;
+        return s_users;
+    }
+
+    OdDbDatabase* m_pDb;
+};
+
+#endif // DWGTHREADSCOPE_H
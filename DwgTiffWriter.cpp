@@ -0,0 +1,254 @@
+#include "DwgTiffWriter.h"
+#include "DwgPixelKernels.h"
+#include "DwgTrace.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace {
+
+// Types des champs TIFF
+const quint16 kShort = 3;
+const quint16 kLong = 4;
+const quint16 kRational = 5;
+const quint16 kLong8 = 16;      // BigTIFF
+
+// Au-delà, les décalages 32 bits du TIFF classique ne suffisent plus
+const quint64 kClassicLimit = Q_UINT64_C(0xF0000000);
+
+struct IfdEntry
+{
+    quint16 tag;
+    quint16 type;
+    quint64 count;
+    QByteArray data;    // Valeurs en petit-boutiste
+};
+
+template <typename T>
+void append(QByteArray& bytes, T value)
+{
+    char buffer[sizeof(T)];
+    qToLittleEndian<T>(value, buffer);
+    bytes.append(buffer, int(sizeof(T)));
+}
+
+IfdEntry shortEntry(quint16 tag, const QVector<quint16>& values)
+{
+    IfdEntry entry { tag, kShort, quint64(values.size()), QByteArray() };
+    for (quint16 value : values)
+        append<quint16>(entry.data, value);
+    return entry;
+}
+
+IfdEntry longEntry(quint16 tag, quint32 value)
+{
+    IfdEntry entry { tag, kLong, 1, QByteArray() };
+    append<quint32>(entry.data, value);
+    return entry;
+}
+
+IfdEntry offsetsEntry(quint16 tag, const QVector<quint64>& values, bool bigTiff)
+{
+    IfdEntry entry { tag, bigTiff ? kLong8 : kLong, quint64(values.size()), QByteArray() };
+    for (quint64 value : values) {
+        if (bigTiff)
+            append<quint64>(entry.data, value);
+        else
+            append<quint32>(entry.data, quint32(value));
+    }
+    return entry;
+}
+
+IfdEntry rationalEntry(quint16 tag, qreal value)
+{
+    // Résolution au centième de point par pouce
+    IfdEntry entry { tag, kRational, 1, QByteArray() };
+    append<quint32>(entry.data, quint32(qRound(value * 100.0)));
+    append<quint32>(entry.data, 100u);
+    return entry;
+}
+
+} // namespace
+
+DwgTiffWriter::~DwgTiffWriter()
+{
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool DwgTiffWriter::open(const QString& path, const QSize& size, qreal dpi)
+{
+    m_size = size;
+    m_dpi = dpi;
+    m_rowsWritten = 0;
+    m_bytesWritten = 0;
+    m_stripRows = 0;
+    m_strip.clear();
+    m_stripOffsets.clear();
+    m_stripByteCounts.clear();
+    m_error.clear();
+    if (size.isEmpty())
+        return fail("Taille d'image invalide");
+
+    // Deflate ne dépasse la taille brute que de quelques octets par bloc
+    const quint64 rawBytes = quint64(size.width()) * quint64(size.height()) * 3u;
+    m_bigTiff = rawBytes + rawBytes / 100 > kClassicLimit;
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return fail(m_file.errorString());
+
+    // En-tête ; le décalage de l'IFD est complété par close()
+    QByteArray header("II", 2);
+    if (m_bigTiff) {
+        append<quint16>(header, 43);
+        append<quint16>(header, 8);
+        append<quint16>(header, 0);
+        append<quint64>(header, 0);
+    } else {
+        append<quint16>(header, 42);
+        append<quint32>(header, 0);
+    }
+    if (m_file.write(header) != header.size())
+        return fail(m_file.errorString());
+
+    m_strip.reserve(size.width() * 3 * kRowsPerStrip);
+    return true;
+}
+
+bool DwgTiffWriter::writeRows(const QImage& rows)
+{
+    if (!m_file.isOpen())
+        return fail("Fichier non ouvert");
+    if (rows.width() != m_size.width() || m_rowsWritten + rows.height() > m_size.height())
+        return fail("Bande hors de l'image");
+
+    QImage source = rows;
+    if (source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32)
+        source = source.convertToFormat(QImage::Format_RGB32);
+
+    const int rowBytes = m_size.width() * 3;
+    for (int y = 0; y < source.height(); ++y) {
+        const int offset = m_strip.size();
+        m_strip.resize(offset + rowBytes);
+        DwgPixelKernels::rgb32ToRgb24(reinterpret_cast<const quint32*>(source.constScanLine(y)),
+                                      reinterpret_cast<uchar*>(m_strip.data()) + offset, m_size.width());
+        ++m_stripRows;
+        ++m_rowsWritten;
+        if ((m_stripRows == kRowsPerStrip || m_rowsWritten == m_size.height()) && !writeStrip())
+            return false;
+    }
+    return true;
+}
+
+bool DwgTiffWriter::writeStrip()
+{
+    DWG_TRACE_SPAN("tiffStrip");
+    // qCompress préfixe le flux zlib de la taille d'origine (4 octets) :
+    // le reste est exactement ce qu'attend la compression Deflate du TIFF
+    const QByteArray compressed = qCompress(m_strip, 6);
+    const char* zlib = compressed.constData() + 4;
+    const qint64 zlibSize = compressed.size() - 4;
+
+    m_stripOffsets.append(quint64(m_file.pos()));
+    m_stripByteCounts.append(quint64(zlibSize));
+    if (m_file.write(zlib, zlibSize) != zlibSize)
+        return fail(m_file.errorString());
+
+    m_strip.resize(0);
+    m_stripRows = 0;
+    return true;
+}
+
+bool DwgTiffWriter::close()
+{
+    if (!m_file.isOpen())
+        return false;
+    if (m_rowsWritten != m_size.height()) {
+        m_file.close();
+        return fail(QString("Image incomplète : %1 lignes sur %2").arg(m_rowsWritten).arg(m_size.height()));
+    }
+
+    QVector<IfdEntry> entries;
+    entries << longEntry(256, quint32(m_size.width()))                  // ImageWidth
+            << longEntry(257, quint32(m_size.height()))                 // ImageLength
+            << shortEntry(258, { 8, 8, 8 })                             // BitsPerSample
+            << shortEntry(259, { 8 })                                   // Compression : Deflate
+            << shortEntry(262, { 2 })                                   // Photometric : RVB
+            << offsetsEntry(273, m_stripOffsets, m_bigTiff)             // StripOffsets
+            << shortEntry(277, { 3 })                                   // SamplesPerPixel
+            << longEntry(278, quint32(kRowsPerStrip))                   // RowsPerStrip
+            << offsetsEntry(279, m_stripByteCounts, m_bigTiff)          // StripByteCounts
+            << shortEntry(284, { 1 });                                  // PlanarConfiguration
+    if (m_dpi > 0.0) {
+        entries << rationalEntry(282, m_dpi)                            // XResolution
+                << rationalEntry(283, m_dpi)                            // YResolution
+                << shortEntry(296, { 2 });                              // ResolutionUnit : pouce
+    }
+    std::sort(entries.begin(), entries.end(), [](const IfdEntry& a, const IfdEntry& b) { return a.tag < b.tag; });
+
+    // IFD aligné sur un mot, valeurs trop longues pour l'entrée placées juste après
+    if (m_file.pos() % 2 != 0)
+        m_file.write("", 1);
+    const quint64 ifdOffset = quint64(m_file.pos());
+    const int inlineSize = m_bigTiff ? 8 : 4;
+    const quint64 ifdSize = m_bigTiff ? 8 + 20 * quint64(entries.size()) + 8
+                                      : 2 + 12 * quint64(entries.size()) + 4;
+
+    QByteArray ifd;
+    QByteArray overflow;
+    if (m_bigTiff)
+        append<quint64>(ifd, quint64(entries.size()));
+    else
+        append<quint16>(ifd, quint16(entries.size()));
+    for (const IfdEntry& entry : entries) {
+        append<quint16>(ifd, entry.tag);
+        append<quint16>(ifd, entry.type);
+        if (m_bigTiff)
+            append<quint64>(ifd, entry.count);
+        else
+            append<quint32>(ifd, quint32(entry.count));
+
+        if (entry.data.size() <= inlineSize) {
+            ifd.append(entry.data);
+            ifd.append(QByteArray(inlineSize - entry.data.size(), '\0'));
+        } else {
+            const quint64 valueOffset = ifdOffset + ifdSize + quint64(overflow.size());
+            if (m_bigTiff)
+                append<quint64>(ifd, valueOffset);
+            else
+                append<quint32>(ifd, quint32(valueOffset));
+            overflow.append(entry.data);
+            if (overflow.size() % 2 != 0)
+                overflow.append('\0');
+        }
+    }
+    // Pas d'IFD suivant
+    if (m_bigTiff)
+        append<quint64>(ifd, 0);
+    else
+        append<quint32>(ifd, 0);
+
+    bool ok = m_file.write(ifd) == ifd.size() && m_file.write(overflow) == overflow.size();
+
+    // Décalage de l'IFD dans l'en-tête
+    QByteArray offset;
+    if (m_bigTiff)
+        append<quint64>(offset, ifdOffset);
+    else
+        append<quint32>(offset, quint32(ifdOffset));
+    ok = ok && m_file.seek(m_bigTiff ? 8 : 4) && m_file.write(offset) == offset.size();
+    if (!ok)
+        m_error = m_file.errorString();
+
+    m_bytesWritten = m_file.size();
+    m_file.close();
+    return ok;
+}
+
+bool DwgTiffWriter::fail(const QString& error)
+{
+    m_error = error;
+    return false;
+}
@@ -0,0 +1,58 @@
+#ifndef DWGTIFFWRITER_H
+#define DWGTIFFWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+// Écriture TIFF en flux, bande par bande : seules les lignes transmises à
+// writeRows() sont en mémoire, jamais l'image entière.
+// RVB 8 bits, bandes TIFF (strips) de kRowsPerStrip lignes compressées en
+// Deflate (zlib de Qt) ; BigTIFF quand le fichier peut dépasser 4 Go.
+// Le répertoire d'image (IFD) est écrit à la fin par close().
+class DwgTiffWriter
+{
+public:
+    static const int kRowsPerStrip = 64;
+
+    DwgTiffWriter() = default;
+    ~DwgTiffWriter();
+
+    // dpi <= 0 : pas de résolution enregistrée
+    bool open(const QString& path, const QSize& size, qreal dpi);
+
+    // Lignes suivantes de l'image, de haut en bas (Format_RGB32 ou ARGB32) ;
+    // toute hauteur est acceptée, les bandes TIFF sont découpées ici
+    bool writeRows(const QImage& rows);
+
+    // Écrit l'IFD ; échoue si toutes les lignes n'ont pas été écrites
+    bool close();
+
+    bool isBigTiff() const { return m_bigTiff; }
+    qint64 bytesWritten() const { return m_bytesWritten; }
+    QString errorString() const { return m_error; }
+
+private:
+    bool writeStrip();
+    bool fail(const QString& error);
+
+    QFile m_file;
+    QSize m_size;
+    qreal m_dpi = 0.0;
+    bool m_bigTiff = false;
+    int m_rowsWritten = 0;
+    qint64 m_bytesWritten = 0;
+
+    // Bande TIFF en cours de remplissage, en RVB 24 bits
+    QByteArray m_strip;
+    int m_stripRows = 0;
+
+    QVector<quint64> m_stripOffsets;
+    QVector<quint64> m_stripByteCounts;
+    QString m_error;
+};
+
+#endif // DWGTIFFWRITER_H
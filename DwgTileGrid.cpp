@@ -0,0 +1,71 @@
+#include "DwgTileGrid.h"
+
+#include <QtMath>
+
+DwgTileGrid::DwgTileGrid(const QRectF& bounds)
+    : m_bounds(bounds.normalized())
+{
+    m_baseSpan = qMax(m_bounds.width(), m_bounds.height());
+}
+
+int DwgTileGrid::levelForScale(qreal pixelsPerUnit) const
+{
+    if (isNull() || pixelsPerUnit <= 0.0)
+        return 0;
+
+    // Échelle du niveau 0 : une tuile pour tout le dessin
+    const qreal baseScale = kTileSize / m_baseSpan;
+    const qreal ratio = pixelsPerUnit / baseScale;
+    if (ratio <= 1.0)
+        return 0;
+
+    // Arrondi supérieur : on ne descend jamais sous la résolution de l'écran
+    const int level = qCeil(std::log2(ratio) - 1e-6);
+    return qBound(0, level, kMaxLevel);
+}
+
+qreal DwgTileGrid::tileSpan(int level) const
+{
+    return std::ldexp(m_baseSpan, -level);
+}
+
+QRectF DwgTileGrid::tileRect(const DwgTileKey& key) const
+{
+    const qreal span = tileSpan(key.level);
+    return QRectF(m_bounds.left() + key.x * span,
+                  m_bounds.top() + key.y * span,
+                  span, span);
+}
+
+QVector<DwgTileKey> DwgTileGrid::tilesIntersecting(const QRectF& rect, int level) const
+{
+    QVector<DwgTileKey> keys;
+    if (isNull())
+        return keys;
+
+    const QRectF area = rect.normalized().intersected(m_bounds);
+    if (area.isEmpty())
+        return keys;
+
+    const qreal span = tileSpan(level);
+    const int lastIndex = (1 << level) - 1;
+
+    const int x0 = qBound(0, int(std::floor((area.left() - m_bounds.left()) / span)), lastIndex);
+    const int x1 = qBound(0, int(std::ceil((area.right() - m_bounds.left()) / span)) - 1, lastIndex);
+    const int y0 = qBound(0, int(std::floor((area.top() - m_bounds.top()) / span)), lastIndex);
+    const int y1 = qBound(0, int(std::ceil((area.bottom() - m_bounds.top()) / span)) - 1, lastIndex);
+
+    keys.reserve((x1 - x0 + 1) * (y1 - y0 + 1));
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x)
+            keys.append(DwgTileKey{level, x, y});
+    }
+    return keys;
+}
+
+DwgTileKey DwgTileGrid::parentOf(const DwgTileKey& key)
+{
+    if (key.level <= 0)
+        return key;
+    return DwgTileKey{key.level - 1, key.x >> 1, key.y >> 1};
+}
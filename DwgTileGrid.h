@@ -0,0 +1,70 @@
+#ifndef DWGTILEGRID_H
+#define DWGTILEGRID_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QRectF>
+#include <QVector>
+
+// Identifiant d'une tuile dans la pyramide : niveau de zoom + position dans la grille
+struct DwgTileKey
+{
+    int level = 0;
+    int x = 0;
+    int y = 0;
+};
+
+inline bool operator==(const DwgTileKey& a, const DwgTileKey& b)
+{
+    return a.level == b.level && a.x == b.x && a.y == b.y;
+}
+
+inline bool operator!=(const DwgTileKey& a, const DwgTileKey& b)
+{
+    return !(a == b);
+}
+
+Q_DECLARE_METATYPE(DwgTileKey)
+
+inline size_t qHash(const DwgTileKey& key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.level, key.x, key.y);
+}
+
+// Découpage de l'espace dessin en tuiles carrées de taille fixe (en pixels)
+// sur des niveaux de zoom en puissances de deux.
+// Le niveau 0 est une seule tuile qui couvre tout le dessin, le niveau N
+// découpe chaque côté en 2^N tuiles.
+// Les rectangles sont exprimés en coordonnées item (Y dessin inversé).
+class DwgTileGrid
+{
+public:
+    static constexpr int kTileSize = 256;
+    static constexpr int kMaxLevel = 24;
+
+    DwgTileGrid() = default;
+    explicit DwgTileGrid(const QRectF& bounds);
+
+    bool isNull() const { return m_baseSpan <= 0.0; }
+    QRectF bounds() const { return m_bounds; }
+
+    // Niveau dont la résolution est au moins égale à l'échelle demandée (pixels par unité)
+    int levelForScale(qreal pixelsPerUnit) const;
+
+    // Côté d'une tuile du niveau donné, en unités dessin
+    qreal tileSpan(int level) const;
+
+    QRectF tileRect(const DwgTileKey& key) const;
+
+    // Tuiles du niveau donné qui touchent le rectangle (coordonnées item)
+    QVector<DwgTileKey> tilesIntersecting(const QRectF& rect, int level) const;
+
+    // Tuile du niveau inférieur qui contient celle-ci
+    static DwgTileKey parentOf(const DwgTileKey& key);
+
+private:
+    QRectF m_bounds;
+    qreal m_baseSpan = 0.0;
+};
+
+#endif // DWGTILEGRID_H
@@ -0,0 +1,215 @@
+#include "DwgTrace.h"
+
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace DwgTrace
+{
+
+namespace detail
+{
+    std::atomic<bool> enabled { false };
+    std::atomic<bool> debugImages { false };
+}
+
+namespace {
+
+// Événements conservés par thread : 16384 x 32 octets = 512 Ko
+const quint64 kRingCapacity = 16384;
+
+struct Event
+{
+    const char* name;
+    qint64 startNs;
+    qint64 endNs;           // Valeur pour un compteur
+    bool counter;
+};
+
+// Un seul écrivain (le thread propriétaire) ; le lecteur vérifie après copie
+// que les entrées lues n'ont pas été réécrites entre-temps
+struct ThreadRing
+{
+    // tid, threadName, first et free sont protégés par s_registryMutex
+    int tid = 0;
+    QString threadName;
+    quint64 first = 0;      // Les entrées antérieures sont celles du propriétaire précédent
+    bool free = false;
+    std::atomic<quint64> head { 0 };
+    Event events[kRingCapacity];
+};
+
+// Les tampons survivent à leurs threads (threads de pool, lots) pour que
+// l'export couvre aussi les threads terminés, jusqu'à ce qu'un nouveau
+// thread reprenne le tampon : leur nombre reste celui des threads vivants
+// au plus fort de l'exécution
+QMutex s_registryMutex;
+std::vector<std::unique_ptr<ThreadRing>> s_rings;
+int s_nextTid = 1;
+
+// Rend le tampon à la sortie du thread
+struct RingOwner
+{
+    ThreadRing* ring = nullptr;
+    ~RingOwner()
+    {
+        if (!ring)
+            return;
+        QMutexLocker lock(&s_registryMutex);
+        ring->free = true;
+    }
+};
+
+ThreadRing* currentRing()
+{
+    thread_local RingOwner t_owner;
+    if (!t_owner.ring) {
+        QMutexLocker lock(&s_registryMutex);
+        ThreadRing* ring = nullptr;
+        for (const std::unique_ptr<ThreadRing>& candidate : s_rings) {
+            if (candidate->free) {
+                ring = candidate.get();
+                break;
+            }
+        }
+        if (!ring) {
+            s_rings.emplace_back(new ThreadRing());
+            ring = s_rings.back().get();
+        }
+        ring->free = false;
+        ring->first = ring->head.load(std::memory_order_relaxed);
+        ring->tid = s_nextTid++;
+        const QString objectName = QThread::currentThread() ? QThread::currentThread()->objectName() : QString();
+        ring->threadName = objectName.isEmpty() ? QString("Thread %1").arg(ring->tid) : objectName;
+        t_owner.ring = ring;
+    }
+    return t_owner.ring;
+}
+
+void append(const Event& event)
+{
+    ThreadRing* ring = currentRing();
+    const quint64 index = ring->head.load(std::memory_order_relaxed);
+    ring->events[index % kRingCapacity] = event;
+    ring->head.store(index + 1, std::memory_order_release);
+}
+
+const auto s_origin = std::chrono::steady_clock::now();
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_origin).count();
+}
+
+void appendJsonString(QByteArray& out, const QString& text)
+{
+    QString escaped = text;
+    escaped.replace('\\', QLatin1String("\\\\")).replace('"', QLatin1String("\\\""));
+    out += '"' + escaped.toUtf8() + '"';
+}
+
+} // namespace
+
+void setEnabled(bool enabled)
+{
+    detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void initFromEnvironment()
+{
+    const QByteArray value = qgetenv("DWG_TRACE");
+    if (!value.isEmpty() && value != "0") {
+        setEnabled(true);
+        qInfo() << "Tracing enabled (DWG_TRACE)";
+    }
+    const QByteArray images = qgetenv("DWG_DEBUG_IMAGES");
+    if (!images.isEmpty() && images != "0") {
+        detail::debugImages.store(true, std::memory_order_relaxed);
+        qInfo() << "Debug images enabled (DWG_DEBUG_IMAGES)";
+    }
+}
+
+void counter(const char* name, qint64 value)
+{
+    if (isEnabled())
+        append(Event { name, nowNs(), value, true });
+}
+
+qint64 Span::now()
+{
+    return nowNs();
+}
+
+void Span::record(const char* name, qint64 startNs, qint64 endNs)
+{
+    append(Event { name, startNs, endNs, false });
+}
+
+bool exportChromeTrace(const QString& path)
+{
+    // Format "JSON Array/Object" de Chrome : événements complets (ph X) en µs
+    QByteArray json;
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    int eventCount = 0;
+
+    QMutexLocker lock(&s_registryMutex);
+    for (const std::unique_ptr<ThreadRing>& ring : s_rings) {
+        if (!first) json += ',';
+        first = false;
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(ring->tid)
+              + ",\"args\":{\"name\":";
+        appendJsonString(json, ring->threadName);
+        json += "}}";
+
+        const quint64 head = ring->head.load(std::memory_order_acquire);
+        const quint64 begin = qMax(ring->first, head > kRingCapacity ? head - kRingCapacity : 0);
+        QVector<Event> copy;
+        copy.reserve(int(head - begin));
+        for (quint64 i = begin; i < head; ++i)
+            copy.append(ring->events[i % kRingCapacity]);
+
+        // Entrées réécrites pendant la copie, y compris celle que le thread
+        // est peut-être en train d'écrire : ignorées
+        const quint64 headAfter = ring->head.load(std::memory_order_acquire) + 1;
+        const quint64 firstValid = headAfter > kRingCapacity ? headAfter - kRingCapacity : 0;
+
+        for (int i = 0; i < copy.size(); ++i) {
+            if (begin + quint64(i) < firstValid)
+                continue;
+            const Event& e = copy.at(i);
+            json += ",{\"name\":";
+            appendJsonString(json, QString::fromLatin1(e.name));
+            if (e.counter) {
+                json += ",\"cat\":\"dwg\",\"ph\":\"C\",\"pid\":1,\"tid\":" + QByteArray::number(ring->tid)
+                      + ",\"ts\":" + QByteArray::number(e.startNs / 1000.0, 'f', 3)
+                      + ",\"args\":{\"value\":" + QByteArray::number(e.endNs) + "}}";
+                ++eventCount;
+                continue;
+            }
+            json += ",\"cat\":\"dwg\",\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number(ring->tid)
+                  + ",\"ts\":" + QByteArray::number(e.startNs / 1000.0, 'f', 3)
+                  + ",\"dur\":" + QByteArray::number((e.endNs - e.startNs) / 1000.0, 'f', 3) + '}';
+            ++eventCount;
+        }
+    }
+    lock.unlock();
+    json += "]}\n";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        qWarning() << "Trace export failed:" << path;
+        return false;
+    }
+    qInfo() << "Trace exported:" << eventCount << "events to" << path;
+    return true;
+}
+
+} // namespace DwgTrace
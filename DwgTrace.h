@@ -0,0 +1,73 @@
+#ifndef DWGTRACE_H
+#define DWGTRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+
+// Traçage léger du pipeline (lecture, emprise, rendu, paint) exportable au
+// format Chrome trace / Perfetto (chrome://tracing, ui.perfetto.dev).
+// Chaque thread écrit ses intervalles et compteurs dans son propre tampon
+// circulaire, sans verrou ; l'export relit les tampons à la demande. Le
+// tampon d'un thread terminé est repris par le prochain thread créé.
+// Désactivé, un intervalle ne coûte qu'une lecture atomique.
+// Activation : variable d'environnement DWG_TRACE=1 ou setEnabled().
+// Les images de débogage (une par thread de rendu, dossier temporaire) ont
+// leur propre interrupteur : DWG_DEBUG_IMAGES=1.
+namespace DwgTrace
+{
+    namespace detail
+    {
+        extern std::atomic<bool> enabled;
+        extern std::atomic<bool> debugImages;
+    }
+
+    inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    inline bool debugImagesEnabled() { return detail::debugImages.load(std::memory_order_relaxed); }
+
+    // Lit DWG_TRACE et DWG_DEBUG_IMAGES ; à appeler une fois au démarrage
+    void initFromEnvironment();
+
+    // Valeur d'un compteur à cet instant (piste "C" du format Chrome).
+    // Le nom doit être une chaîne statique, comme pour Span
+    void counter(const char* name, qint64 value);
+
+    // Écrit les intervalles encore présents dans les tampons ; false en cas d'erreur d'écriture
+    bool exportChromeTrace(const QString& path);
+
+    // Intervalle chronométré, enregistré à la destruction.
+    // Le nom doit être une chaîne statique (seul le pointeur est conservé).
+    class Span
+    {
+    public:
+        explicit Span(const char* name)
+            : m_name(isEnabled() ? name : nullptr)
+            , m_startNs(m_name ? now() : 0)
+        {
+        }
+        ~Span()
+        {
+            if (m_name)
+                record(m_name, m_startNs, now());
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        static qint64 now();
+        static void record(const char* name, qint64 startNs, qint64 endNs);
+
+        const char* m_name;
+        qint64 m_startNs;
+    };
+}
+
+#define DWG_TRACE_CONCAT_(a, b) a##b
+#define DWG_TRACE_CONCAT(a, b) DWG_TRACE_CONCAT_(a, b)
+#define DWG_TRACE_SPAN(name) DwgTrace::Span DWG_TRACE_CONCAT(dwgTraceSpan_, __LINE__)(name)
+
+#endif // DWGTRACE_H
@@ -0,0 +1,34 @@
+# Visionneuse interactive
+QT += widgets openglwidgets
+
+TARGET = DwgViewerGs
+
+include(DwgCommon.pri)
+
+SOURCES += \
+    main.cpp \
+    mainwindow.cpp \
+    DwgRendererItem.cpp \
+    DwgLoader.cpp \
+    DwgRenderWorker.cpp \
+    DwgDiskCache.cpp \
+    DwgGraphicsView.cpp \
+    DwgLayoutBrowser.cpp \
+    DwgLiveReload.cpp \
+    DwgDisplayList.cpp \
+    DwgDisplayListVectorizer.cpp \
+    DwgSpatialIndex.cpp \
+    DwgTextIndex.cpp
+
+HEADERS += \
+    mainwindow.h \
+    DwgRendererItem.h \
+    DwgLoader.h \
+    DwgRenderWorker.h \
+    DwgDiskCache.h \
+    DwgGraphicsView.h \
+    DwgLayoutBrowser.h \
+    DwgLiveReload.h \
+    DwgDisplayList.h \
+    DwgSpatialIndex.h \
+    DwgTextIndex.h
@@ -1,12 +1,201 @@
 #include <OdaCommon.h> // TOUJOURS EN PREMIER
 #include "MyServices.h"
+#include "DwgMemory.h"
 
 // Nécessaire pour accéder aux noms des modules (OdWinBitmapModuleName)
 #include "RxDynamicModule.h"
 #include "OdModuleNames.h"
+#include "OdStreamBuf.h"
+#include "RxObjectImpl.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
 
 MyServices* g_pServices = nullptr;
 
+// Chaque thread de lecture installe son propre listener
+static thread_local MyProgressListener* t_pProgressListener = nullptr;
+
+static std::atomic<bool> s_mappedFileInput { true };
+
+// Lecture partielle en cours sur ce thread (readFile appelle createFile)
+static thread_local bool t_partialLoadRead = false;
+
+// Projection interdite aux lectures de ce thread (setThreadMappedFileInput)
+static thread_local bool t_bufferedFileInput = false;
+
+namespace {
+
+// Flux en lecture seule sur un fichier projeté en mémoire : chaque lecture
+// est une copie mémoire, sans appel système ni tampon intermédiaire
+class MappedStreamBuf : public OdStreamBuf
+{
+public:
+    // Flux nul si le fichier ne peut pas être projeté (vide, verrouillé...)
+    static OdStreamBufPtr open(const OdString& fileName)
+    {
+        std::unique_ptr<QFile> file(new QFile(QString::fromWCharArray((const wchar_t*)fileName.c_str())));
+        if (!file->open(QIODevice::ReadOnly) || file->size() <= 0)
+            return OdStreamBufPtr();
+
+        const qint64 size = file->size();
+        uchar* data = file->map(0, size);
+        if (!data)
+            return OdStreamBufPtr();
+
+#ifdef Q_OS_UNIX
+        // Lecture globalement séquentielle : lecture anticipée agressive,
+        // et chargement de tout le fichier lancé dès maintenant
+        madvise(data, size_t(size), MADV_SEQUENTIAL);
+        madvise(data, size_t(size), MADV_WILLNEED);
+#endif
+
+        OdSmartPtr<MappedStreamBuf> pStream = OdRxObjectImpl<MappedStreamBuf>::createObject();
+        pStream->m_fileName = fileName;
+        pStream->m_file = std::move(file);
+        pStream->m_data = data;
+        pStream->m_size = size;
+        return pStream;
+    }
+
+    OdString fileName() override { return m_fileName; }
+    OdUInt64 length() override { return OdUInt64(m_size); }
+    OdUInt64 tell() override { return OdUInt64(m_pos); }
+    bool isEof() override { return m_pos >= m_size; }
+
+    OdUInt64 seek(OdInt64 offset, OdDb::FilerSeekType seekType) override
+    {
+        qint64 base = 0;
+        if (seekType == OdDb::kSeekFromCurrent)
+            base = m_pos;
+        else if (seekType == OdDb::kSeekFromEnd)
+            base = m_size;
+
+        const qint64 pos = base + offset;
+        if (pos < 0 || pos > m_size)
+            throw OdError(eEndOfFile);
+        m_pos = pos;
+        return OdUInt64(m_pos);
+    }
+
+    OdUInt8 getByte() override
+    {
+        if (m_pos >= m_size)
+            throw OdError(eEndOfFile);
+        return m_data[m_pos++];
+    }
+
+    void getBytes(void* buffer, OdUInt32 numBytes) override
+    {
+        if (m_size - m_pos < qint64(numBytes))
+            throw OdError(eEndOfFile);
+        std::memcpy(buffer, m_data + m_pos, numBytes);
+        m_pos += numBytes;
+    }
+
+    void copyDataTo(OdStreamBuf* pDestination, OdUInt64 sourceStart, OdUInt64 sourceEnd) override
+    {
+        if (sourceStart > sourceEnd || sourceEnd > OdUInt64(m_size))
+            throw OdError(eEndOfFile);
+        pDestination->putBytes(m_data + sourceStart, OdUInt32(sourceEnd - sourceStart));
+    }
+
+private:
+    OdString m_fileName;
+    std::unique_ptr<QFile> m_file;      // La projection vit tant que le fichier est ouvert
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_pos = 0;
+};
+
+} // namespace
+
+OdStreamBufPtr MyServices::createFile(const OdString& filename,
+                                      Oda::FileAccessMode accessMode,
+                                      Oda::FileShareMode shareMode,
+                                      Oda::FileCreationDisposition creationDisposition)
+{
+    // En lecture partielle, le flux reste ouvert tant que la base vit : un
+    // fichier réécrit sur place pendant ce temps (enregistrement depuis un
+    // poste CAO) ferait fauter tout accès à la projection
+    if (s_mappedFileInput && !t_partialLoadRead && !t_bufferedFileInput
+        && accessMode == Oda::kFileRead && creationDisposition == Oda::kOpenExisting) {
+        OdStreamBufPtr pStream = MappedStreamBuf::open(filename);
+        if (!pStream.isNull())
+            return pStream;
+    }
+    return ExSystemServices::createFile(filename, accessMode, shareMode, creationDisposition);
+}
+
+OdDbDatabasePtr MyServices::readFile(const OdString& filename, bool allowCPConversion, bool partialLoad,
+                                     Oda::FileShareMode shareMode, const OdPassword& password)
+{
+    const QString path = QString::fromWCharArray((const wchar_t*)filename.c_str());
+    const int document = DwgMemory::createDocument(QFileInfo(path).fileName());
+
+    OdDbDatabasePtr pDb;
+    t_partialLoadRead = partialLoad;
+    try {
+        DwgMemory::DocumentScope memoryScope(document);
+        pDb = ExHostAppServices::readFile(filename, allowCPConversion, partialLoad, shareMode, password);
+    } catch (...) {
+        t_partialLoadRead = false;
+        DwgMemory::closeDocument(document);
+        throw;
+    }
+    t_partialLoadRead = false;
+
+    if (pDb.isNull())
+        DwgMemory::closeDocument(document);
+    else
+        DwgMemory::attach(pDb.get(), document);
+    return pDb;
+}
+
+qint64 MyServices::closeDatabase(OdDbDatabasePtr& pDb)
+{
+    if (pDb.isNull())
+        return 0;
+
+    // Détachée avant la libération : l'adresse peut resservir à la base suivante
+    const int document = DwgMemory::documentFor(pDb.get());
+    DwgMemory::detach(pDb.get());
+
+    QElapsedTimer timer;
+    timer.start();
+    {
+        DwgMemory::DocumentScope memoryScope(document);
+        pDb.release();
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    DwgMemory::closeDocument(document);
+    return elapsedNs;
+}
+
+void MyServices::setMappedFileInput(bool enabled)
+{
+    s_mappedFileInput = enabled;
+}
+
+bool MyServices::mappedFileInput()
+{
+    return s_mappedFileInput;
+}
+
+void MyServices::setThreadMappedFileInput(bool enabled)
+{
+    t_bufferedFileInput = !enabled;
+}
+
 // Implémentation de la fonction requise en statique
 OdGsDevicePtr MyServices::gsBitmapDevice(OdRxObject* /*pViewObj*/,
                                          OdDbBaseDatabase* /*pDb*/,
@@ -27,3 +216,67 @@ OdGsDevicePtr MyServices::gsBitmapDevice(OdRxObject* /*pViewObj*/,
     }
     return OdGsDevicePtr();
 }
+
+OdDbHostAppProgressMeter* MyServices::newProgressMeter()
+{
+    return new MyProgressMeter();
+}
+
+void MyServices::releaseProgressMeter(OdDbHostAppProgressMeter* pProgressMeter)
+{
+    delete static_cast<MyProgressMeter*>(pProgressMeter);
+}
+
+void MyServices::setThreadProgressListener(MyProgressListener* pListener)
+{
+    t_pProgressListener = pListener;
+}
+
+MyProgressListener* MyServices::threadProgressListener()
+{
+    return t_pProgressListener;
+}
+
+void MyProgressMeter::start(const OdString& displayString)
+{
+    m_stage = QString::fromWCharArray((const wchar_t*)displayString.c_str());
+    m_current = 0;
+    m_lastPercent = -1;
+    notify();
+}
+
+void MyProgressMeter::stop()
+{
+    m_current = m_limit;
+    notify();
+}
+
+void MyProgressMeter::meterProgress()
+{
+    // L'annulation n'est vérifiée qu'ici : stop() peut être appelé pendant un déroulement de pile
+    MyProgressListener* pListener = t_pProgressListener;
+    if (pListener && pListener->isCancelled())
+        throw OdError(eUserBreak);
+
+    ++m_current;
+    notify();
+}
+
+void MyProgressMeter::setLimit(int max)
+{
+    m_limit = max;
+}
+
+void MyProgressMeter::notify()
+{
+    MyProgressListener* pListener = t_pProgressListener;
+    if (!pListener)
+        return;
+
+    // On ne relaie que les changements de pourcentage
+    const int percent = m_limit > 0 ? qBound(0, int(qint64(m_current) * 100 / m_limit), 100) : 0;
+    if (percent != m_lastPercent) {
+        m_lastPercent = percent;
+        pListener->onProgress(m_stage, percent);
+    }
+}
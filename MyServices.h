@@ -6,6 +6,36 @@
 #include "ExSystemServices.h"
 #include "ExHostAppServices.h"
 
+#include <QString>
+
+// Reçoit l'avancement des lectures lancées depuis le thread où il est installé
+class MyProgressListener
+{
+public:
+    virtual ~MyProgressListener() {}
+    virtual void onProgress(const QString& stage, int percent) = 0;
+    // Une lecture annulée est interrompue au prochain pas d'avancement (OdError eUserBreak)
+    virtual bool isCancelled() const = 0;
+};
+
+// Indicateur d'avancement Teigha qui relaie vers le listener du thread courant
+class MyProgressMeter : public OdDbHostAppProgressMeter
+{
+public:
+    void start(const OdString& displayString = OdString::kEmpty) override;
+    void stop() override;
+    void meterProgress() override;
+    void setLimit(int max) override;
+
+private:
+    void notify();
+
+    QString m_stage;
+    int m_limit = 0;
+    int m_current = 0;
+    int m_lastPercent = -1;
+};
+
 // Classe de services combinant les services système et l'hôte d'application
 class MyServices : public ExSystemServices, public ExHostAppServices
 {
@@ -17,6 +47,46 @@ public:
     virtual OdGsDevicePtr gsBitmapDevice(OdRxObject* pViewObj = NULL,
                                          OdDbBaseDatabase* pDb = NULL,
                                          OdUInt32 flags = 0);
+
+    // Avancement des lectures : relayé au listener du thread appelant
+    virtual OdDbHostAppProgressMeter* newProgressMeter();
+    virtual void releaseProgressMeter(OdDbHostAppProgressMeter* pProgressMeter);
+
+    // Listener du thread courant (nullptr pour le retirer)
+    static void setThreadProgressListener(MyProgressListener* pListener);
+    static MyProgressListener* threadProgressListener();
+
+    // Fichiers ouverts en lecture seule (lecture des plans, aperçus) :
+    // projetés en mémoire plutôt que lus par appels système, avec retour
+    // au flux tamponné de Teigha si la projection échoue. Jamais pendant
+    // une lecture partielle, dont le flux vit aussi longtemps que la base
+    OdStreamBufPtr createFile(const OdString& filename,
+                              Oda::FileAccessMode accessMode = Oda::kFileRead,
+                              Oda::FileShareMode shareMode = Oda::kShareDenyNo,
+                              Oda::FileCreationDisposition creationDisposition = Oda::kOpenExisting) override;
+
+    // Chaque base lue a son arène mémoire (DwgMemory) : tout ce qui est
+    // alloué pendant la lecture lui est attribué
+    OdDbDatabasePtr readFile(const OdString& filename,
+                             bool allowCPConversion = false,
+                             bool partialLoad = false,
+                             Oda::FileShareMode shareMode = Oda::kShareDenyWrite,
+                             const OdPassword& password = OdPassword()) override;
+
+    // Libère la base (le pointeur est remis à zéro) et ferme son arène ;
+    // renvoie la durée de la libération en ns
+    static qint64 closeDatabase(OdDbDatabasePtr& pDb);
+
+    // Projection mémoire des fichiers lus (activée par défaut). Un fichier
+    // tronqué pendant qu'on lit sa projection tue le processus (SIGBUS),
+    // sans erreur rattrapable : les lectures d'un fichier qu'un autre
+    // programme peut être en train de réécrire (rechargement à chaud)
+    // passent par setThreadMappedFileInput(false)
+    static void setMappedFileInput(bool enabled);
+    static bool mappedFileInput();
+
+    // Désactive la projection pour les lectures du thread courant seulement
+    static void setThreadMappedFileInput(bool enabled);
 };
 
 // Déclaration externe du pointeur global pour qu'il soit visible partout
@@ -0,0 +1,13 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QtGlobal>
+
+// Mémoire résidente du processus, en octets (-1 si indisponible sur la plateforme)
+namespace ProcessMemory
+{
+    qint64 currentRss();
+    qint64 peakRss();
+}
+
+#endif // PROCESSMEMORY_H
@@ -0,0 +1,39 @@
+#include "OdaCommon.h"
+#include "StaticModules.h"
+
+// La map doit être dans le même cpp que ODRX_INIT_STATIC_MODULE_MAP()
+
+// Headers requis pour les macros statiques
+#include <RxDynamicModule.h>
+#include <OdModuleNames.h>
+
+// 1. DÉCLARATIONS
+ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(OdRecomputeDimBlockModule);
+#ifdef _WIN32
+ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(WinGDIModule);
+ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(WinOpenGLModule);
+#endif
+ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(BitmapModule);       // Rendu hors écran (toutes plateformes)
+ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(ModelerModule);      // CRITIQUE pour les plans avec 3D
+ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(ExRasterModule);     // CRITIQUE pour les images/logos
+ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(OdRasterProcessingServicesImpl);
+
+// 2. MAP
+ODRX_BEGIN_STATIC_MODULE_MAP()
+#ifdef _WIN32
+ODRX_DEFINE_STATIC_APPMODULE(OdWinOpenGLModuleName, WinOpenGLModule)
+ODRX_DEFINE_STATIC_APPMODULE(OdWinGDIModuleName, WinGDIModule)
+#endif
+ODRX_DEFINE_STATIC_APPMODULE(OdWinBitmapModuleName, BitmapModule)
+ODRX_DEFINE_STATIC_APPMODULE(OdRecomputeDimBlockModuleName, OdRecomputeDimBlockModule)
+// Modules additionnels pour éviter les crashs sur entités complexes
+ODRX_DEFINE_STATIC_APPMODULE(OdModelerGeometryModuleName, ModelerModule)
+ODRX_DEFINE_STATIC_APPMODULE(RX_RASTER_SERVICES_APPNAME, ExRasterModule)
+ODRX_DEFINE_STATIC_APPMODULE(OdRasterProcessorModuleName, OdRasterProcessingServicesImpl)
+ODRX_END_STATIC_MODULE_MAP()
+
+void initStaticModules()
+{
+    // Enregistre les modules déclarés plus haut (comme RecomputeDimBlock)
+    ODRX_INIT_STATIC_MODULE_MAP();
+}
@@ -0,0 +1,9 @@
+#ifndef STATICMODULES_H
+#define STATICMODULES_H
+
+// Modules Teigha liés statiquement (device bitmap, raster, modeleur...).
+// Partagé par la visionneuse et les outils en ligne de commande.
+// À appeler avant odInitialize().
+void initStaticModules();
+
+#endif // STATICMODULES_H
@@ -0,0 +1,307 @@
+#include "OdaCommon.h"
+#include "MyServices.h"
+#include "StaticRxObject.h"
+#include "StaticModules.h"
+
+#include "DwgExtents.h"
+#include "DwgOffscreenRenderer.h"
+#include "DwgStripExport.h"
+#include "DwgThreadScope.h"
+#include "DwgTrace.h"
+#include "ProcessMemory.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+#include <stdexcept>
+
+// Rendu en lot de fichiers DWG vers des aperçus PNG, sans affichage
+// (plateforme Qt "offscreen" par défaut), sur plusieurs threads.
+// L'arborescence des dossiers donnés en entrée est reproduite sous --output.
+// --tiff : export grand format (feuille --paper à --dpi) rendu en bandes et
+// écrit au fil de l'eau, sans l'image complète en mémoire.
+
+namespace {
+
+struct FileResult
+{
+    QString path;
+    bool ok = false;
+    QString error;
+    QString format = "PNG";
+    QSize size;
+    qint64 loadMs = 0;
+    qint64 renderMs = 0;
+    qint64 saveMs = 0;      // TIFF : encodage, en parallèle du rendu
+};
+
+struct TiffOptions
+{
+    bool enabled = false;
+    QSizeF paperMm;         // Vide : côté le plus long = --size
+    qreal dpi = 0.0;
+    int bandHeight = 512;
+};
+
+struct InputFile
+{
+    QString path;
+    QString outputName;     // Relatif au dossier de sortie, sans extension
+};
+
+// Les fichiers trouvés dans un dossier gardent leur chemin relatif à ce
+// dossier (sous-dossiers recréés sous --output) ; les noms encore en
+// collision (même fichier relatif sous deux dossiers donnés) sont suffixés
+QVector<InputFile> collectInputs(const QStringList& inputs, bool recursive)
+{
+    QVector<InputFile> files;
+    for (const QString& input : inputs) {
+        const QFileInfo info(input);
+        if (info.isDir()) {
+            const QDir root(info.absoluteFilePath());
+            QDirIterator it(root.path(), QStringList() << "*.dwg" << "*.DWG", QDir::Files,
+                            recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+            while (it.hasNext()) {
+                const QFileInfo file(it.next());
+                const QString relativeDir = root.relativeFilePath(file.absolutePath());
+                files.append({ file.absoluteFilePath(), QDir::cleanPath(QDir(relativeDir).filePath(file.completeBaseName())) });
+            }
+        } else if (info.isFile()) {
+            files.append({ info.absoluteFilePath(), info.completeBaseName() });
+        } else {
+            QTextStream(stderr) << "Ignoré (introuvable) : " << input << Qt::endl;
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const InputFile& a, const InputFile& b) { return a.path < b.path; });
+    files.erase(std::unique(files.begin(), files.end(),
+                            [](const InputFile& a, const InputFile& b) { return a.path == b.path; }),
+                files.end());
+
+    // Comparaison sans casse : dossiers de sortie Windows ou macOS
+    QSet<QString> taken;
+    for (InputFile& file : files) {
+        QString name = file.outputName;
+        for (int n = 2; taken.contains(name.toLower()); ++n)
+            name = QString("%1_%2").arg(file.outputName).arg(n);
+        taken.insert(name.toLower());
+        file.outputName = name;
+    }
+    return files;
+}
+
+FileResult renderFile(const QString& path, const QString& outputBase, int maxSide, const TiffOptions& tiff)
+{
+    DwgThreadScope threadScope;
+
+    FileResult result;
+    result.path = path;
+    QElapsedTimer timer;
+
+    try
+    {
+        timer.start();
+        OdDbDatabasePtr pDb;
+        {
+            DWG_TRACE_SPAN("readFile");
+            pDb = g_pServices->readFile((const wchar_t*)path.toStdWString().c_str());
+        }
+        result.loadMs = timer.elapsed();
+        if (pDb.isNull()) throw std::runtime_error("Impossible de lire le fichier DWG.");
+
+        timer.restart();
+        const QRectF bounds = DwgExtents::exactBounds(pDb.get());
+        if (bounds.isEmpty()) throw std::runtime_error("Emprise du dessin invalide.");
+
+        // Côté le plus long = maxSide, en conservant les proportions
+        const qreal scale = maxSide / qMax(bounds.width(), bounds.height());
+        const QSize size(qMax(1, qRound(bounds.width() * scale)), qMax(1, qRound(bounds.height() * scale)));
+
+        if (tiff.enabled) {
+            DwgStripExportSettings settings;
+            settings.region = bounds;
+            settings.size = tiff.paperMm.isEmpty() ? size : DwgStripExport::fitToPaper(bounds, tiff.paperMm, tiff.dpi);
+            settings.dpi = tiff.dpi;
+            settings.bandHeight = tiff.bandHeight;
+            result.format = "TIFF";
+            result.size = settings.size;
+
+            const QString outPath = outputBase + ".tif";
+            const DwgStripExportResult exported = DwgStripExport::exportTiff(pDb, outPath, settings);
+            pDb.release();
+            if (!exported.ok)
+                throw std::runtime_error(exported.error.toStdString());
+            result.renderMs = exported.renderMs;
+            result.saveMs = exported.encodeMs;
+            result.ok = true;
+            return result;
+        }
+
+        QImage image;
+        {
+            DwgOffscreenRenderer renderer(pDb);
+            if (!renderer.render(bounds, size, image))
+                throw std::runtime_error("Échec du rendu.");
+        }
+        pDb.release();
+        result.renderMs = timer.elapsed();
+        result.size = image.size();
+
+        timer.restart();
+        DWG_TRACE_SPAN("savePng");
+        const QString outPath = outputBase + ".png";
+        if (!image.save(outPath))
+            throw std::runtime_error("Écriture PNG impossible.");
+        result.saveMs = timer.elapsed();
+        result.ok = true;
+    }
+    catch (const OdError& e)
+    {
+        result.error = QString::fromWCharArray((const wchar_t*)e.description().c_str());
+    }
+    catch (const std::exception& ex)
+    {
+        result.error = QString::fromUtf8(ex.what());
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Aucun affichage nécessaire : plateforme offscreen sauf choix explicite
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication a(argc, argv);
+    QCoreApplication::setOrganizationName("stslu");
+    QCoreApplication::setApplicationName("DwgBatchRender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Rendu en lot de fichiers DWG en aperçus PNG.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("inputs", "Fichiers DWG ou dossiers à traiter.", "<fichiers|dossiers...>");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Dossier de sortie.", "dossier", ".");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Nombre de threads de rendu.", "n",
+                                  QString::number(QThread::idealThreadCount()));
+    QCommandLineOption sizeOption(QStringList() << "s" << "size", "Côté le plus long de l'image, en pixels.", "px", "1024");
+    QCommandLineOption recursiveOption(QStringList() << "r" << "recursive", "Parcourt les sous-dossiers.");
+    QCommandLineOption traceOption("trace", "Exporte une trace Chrome / Perfetto des étapes.", "fichier");
+    QCommandLineOption tiffOption("tiff", "Export TIFF grand format, rendu et écrit en bandes.");
+    QCommandLineOption paperOption("paper", "Feuille de l'export TIFF (A0 à A4) ; sinon --size.", "format");
+    QCommandLineOption dpiOption("dpi", "Résolution de l'export TIFF sur la feuille.", "dpi", "300");
+    QCommandLineOption bandOption("band", "Lignes rendues par bande (export TIFF).", "lignes", "512");
+    parser.addOption(outputOption);
+    parser.addOption(jobsOption);
+    parser.addOption(sizeOption);
+    parser.addOption(recursiveOption);
+    parser.addOption(traceOption);
+    parser.addOption(tiffOption);
+    parser.addOption(paperOption);
+    parser.addOption(dpiOption);
+    parser.addOption(bandOption);
+    parser.process(a);
+
+    const QVector<InputFile> files = collectInputs(parser.positionalArguments(), parser.isSet(recursiveOption));
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    const QString outputDir = parser.value(outputOption);
+    const int jobs = qMax(1, parser.value(jobsOption).toInt());
+    const int maxSide = qMax(16, parser.value(sizeOption).toInt());
+    QDir().mkpath(outputDir);
+
+    // Exemple : --tiff --paper A0 --dpi 600, environ 20000 x 28000 pixels
+    TiffOptions tiff;
+    tiff.enabled = parser.isSet(tiffOption);
+    tiff.dpi = qMax(1.0, parser.value(dpiOption).toDouble());
+    tiff.bandHeight = qMax(16, parser.value(bandOption).toInt());
+    if (parser.isSet(paperOption)) {
+        tiff.paperMm = DwgStripExport::paperSizeMm(parser.value(paperOption));
+        if (tiff.paperMm.isEmpty())
+            parser.showHelp(1);
+    }
+
+    DwgTrace::initFromEnvironment();
+    if (parser.isSet(traceOption))
+        DwgTrace::setEnabled(true);
+
+    // --- Initialisation de Teigha ---
+    initStaticModules();
+    OdStaticRxObject<MyServices> services;
+    g_pServices = &services;
+    odInitialize(&services);
+
+    QTextStream out(stdout);
+    QVector<FileResult> results;
+    results.reserve(files.size());
+    QMutex resultsMutex;
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(jobs);
+        for (const InputFile& file : files) {
+            const QString path = file.path;
+            const QString outputBase = QDir(outputDir).filePath(file.outputName);
+            QDir().mkpath(QFileInfo(outputBase).path());
+            pool.start([&, path, outputBase]() {
+                const FileResult result = renderFile(path, outputBase, maxSide, tiff);
+                QMutexLocker lock(&resultsMutex);
+                results.append(result);
+                if (result.ok)
+                    out << "OK   " << path << "  " << result.size.width() << "x" << result.size.height()
+                        << "  lecture " << result.loadMs << " ms, rendu " << result.renderMs
+                        << " ms, " << result.format << " " << result.saveMs << " ms" << Qt::endl;
+                else
+                    out << "FAIL " << path << "  " << result.error << Qt::endl;
+            });
+        }
+        pool.waitForDone();
+    }
+    const qint64 wallMs = wallTimer.elapsed();
+
+    // --- Nettoyage de Teigha ---
+    odUninitialize();
+    g_pServices = nullptr;
+
+    // --- Rapport ---
+    int succeeded = 0;
+    qint64 totalLoad = 0, totalRender = 0, totalSave = 0;
+    for (const FileResult& r : results) {
+        if (!r.ok) continue;
+        ++succeeded;
+        totalLoad += r.loadMs;
+        totalRender += r.renderMs;
+        totalSave += r.saveMs;
+    }
+    const double seconds = qMax<qint64>(1, wallMs) / 1000.0;
+
+    out << Qt::endl
+        << "Fichiers      : " << succeeded << " / " << files.size() << " réussis, " << jobs << " threads" << Qt::endl
+        << "Durée totale  : " << wallMs << " ms (" << QString::number(files.size() / seconds, 'f', 2) << " fichiers/s)" << Qt::endl;
+    if (succeeded > 0) {
+        out << "Moyenne       : lecture " << totalLoad / succeeded << " ms, rendu " << totalRender / succeeded
+            << " ms, " << (tiff.enabled ? "TIFF" : "PNG") << " " << totalSave / succeeded << " ms" << Qt::endl;
+    }
+    out << "Mémoire crête : " << ProcessMemory::peakRss() / (1024 * 1024) << " Mo" << Qt::endl;
+
+    if (parser.isSet(traceOption) && DwgTrace::exportChromeTrace(parser.value(traceOption)))
+        out << "Trace         : " << parser.value(traceOption) << Qt::endl;
+
+    return succeeded == files.size() ? 0 : 2;
+}
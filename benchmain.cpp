@@ -0,0 +1,546 @@
+#include "OdaCommon.h"
+#include "MyServices.h"
+#include "StaticRxObject.h"
+#include "StaticModules.h"
+
+#include "DwgExtents.h"
+#include "DwgMemory.h"
+#include "DwgOffscreenRenderer.h"
+#include "DwgPixelKernels.h"
+#include "DwgThreadScope.h"
+#include "DwgTileGrid.h"
+#include "ProcessMemory.h"
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+// Banc de mesure reproductible du pipeline : chaque étape (lecture, emprise,
+// préparation des vues, vectorisation, copie raster) est chronométrée
+// séparément sur plusieurs itérations après échauffement. Les résultats JSON
+// se comparent d'une build à l'autre (--compare).
+// --scaling mesure le débit du rendu de tuiles selon le nombre de threads.
+// --file-input compare la lecture par projection mémoire et tamponnée,
+// --allocator les pools de DwgMemory et le tas système.
+// --kernels mesure les noyaux de pixels de chaque jeu d'instructions (MPix/s).
+
+namespace {
+
+// Étapes mesurées, dans l'ordre du pipeline
+const char* const kStages[] = {
+    "readFile",             // g_pServices->readFile
+    "getGeomExtents",       // DwgExtents::exactBounds
+    "setupLayoutViews",     // device + setupActiveLayoutViews
+    "deviceUpdate",         // pDevice->update(), premier rendu
+    "rasterCopy",           // raster -> QImage
+    "deviceUpdateCached",   // second rendu (zoom) avec le cache GS déjà rempli
+    "closeDatabase",        // libération de la base (MyServices::closeDatabase)
+};
+
+typedef QMap<QString, QVector<double>> StageSamples;   // étape -> durées en ms
+
+QStringList collectInputs(const QStringList& inputs)
+{
+    QStringList files;
+    for (const QString& input : inputs) {
+        const QFileInfo info(input);
+        if (info.isDir()) {
+            QDirIterator it(input, QStringList() << "*.dwg" << "*.DWG", QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+                files << it.next();
+        } else if (info.isFile()) {
+            files << info.absoluteFilePath();
+        }
+    }
+    files.sort();
+    files.removeDuplicates();
+    return files;
+}
+
+double toMs(qint64 ns)
+{
+    return ns / 1.0e6;
+}
+
+// Une itération complète sur un fichier
+void runIteration(const QString& path, int size, StageSamples& samples, DwgMemoryStats& memory)
+{
+    QElapsedTimer timer;
+
+    timer.start();
+    OdDbDatabasePtr pDb = g_pServices->readFile((const wchar_t*)path.toStdWString().c_str());
+    samples["readFile"].append(toMs(timer.nsecsElapsed()));
+    if (pDb.isNull()) throw std::runtime_error("Impossible de lire le fichier DWG.");
+
+    timer.restart();
+    const QRectF bounds = DwgExtents::exactBounds(pDb.get());
+    samples["getGeomExtents"].append(toMs(timer.nsecsElapsed()));
+    if (bounds.isEmpty()) throw std::runtime_error("Emprise du dessin invalide.");
+
+    const qreal scale = size / qMax(bounds.width(), bounds.height());
+    const QSize imageSize(qMax(1, qRound(bounds.width() * scale)), qMax(1, qRound(bounds.height() * scale)));
+
+    {
+        DwgOffscreenRenderer renderer(pDb);
+        QImage image;
+        if (!renderer.render(bounds, imageSize, image))
+            throw std::runtime_error("Échec du rendu.");
+        samples["setupLayoutViews"].append(toMs(renderer.lastTimings().setupNs));
+        samples["deviceUpdate"].append(toMs(renderer.lastTimings().updateNs));
+        samples["rasterCopy"].append(toMs(renderer.lastTimings().copyNs));
+
+        // Zoom x2 sur le centre : mesure le gain du device persistant
+        QRectF zoomed(0, 0, bounds.width() / 2, bounds.height() / 2);
+        zoomed.moveCenter(bounds.center());
+        if (!renderer.render(zoomed, imageSize, image))
+            throw std::runtime_error("Échec du second rendu.");
+        samples["deviceUpdateCached"].append(toMs(renderer.lastTimings().updateNs));
+    }
+
+    // Fermeture : libération de tous les objets de la base (pools ou tas système)
+    memory = DwgMemory::stats(DwgMemory::documentFor(pDb.get()));
+    samples["closeDatabase"].append(toMs(MyServices::closeDatabase(pDb)));
+}
+
+QJsonObject memoryToJson(const DwgMemoryStats& memory)
+{
+    QJsonArray sizeClasses;
+    for (const DwgSizeClassStats& sizeClass : memory.sizeClasses) {
+        QJsonObject object;
+        object["size"] = sizeClass.size;
+        object["live"] = double(sizeClass.live);
+        object["allocations"] = double(sizeClass.allocations);
+        sizeClasses.append(object);
+    }
+
+    QJsonObject object;
+    object["currentBytes"] = double(memory.currentBytes);
+    object["peakBytes"] = double(memory.peakBytes);
+    object["reservedBytes"] = double(memory.reservedBytes);
+    object["allocations"] = double(memory.allocations);
+    object["frees"] = double(memory.frees);
+    object["sizeClasses"] = sizeClasses;
+    return object;
+}
+
+// Passage à l'échelle : toutes les tuiles d'un niveau de la pyramide, rendues
+// par N threads ayant chacun leur device sur la même base
+QJsonArray runScaling(const QString& path, const QList<int>& threadCounts, int level, QTextStream& out)
+{
+    OdDbDatabasePtr pDb = g_pServices->readFile((const wchar_t*)path.toStdWString().c_str());
+    if (pDb.isNull()) throw std::runtime_error("Impossible de lire le fichier DWG.");
+
+    const DwgTileGrid grid(DwgExtents::exactBounds(pDb.get()));
+    if (grid.isNull()) throw std::runtime_error("Emprise du dessin invalide.");
+    const QVector<DwgTileKey> keys = grid.tilesIntersecting(grid.bounds(), level);
+    const QSize tileSize(DwgTileGrid::kTileSize, DwgTileGrid::kTileSize);
+
+    QJsonArray runs;
+    double singleThreadRate = 0.0;
+    for (int threadCount : threadCounts) {
+        pDb->setMultiThreadedMode(threadCount > 1 ? OdDb::kMTRendering : OdDb::kSTMode);
+
+        std::atomic<int> next { 0 };
+        std::atomic<int> failed { 0 };
+        std::vector<QThread*> threads;
+        QElapsedTimer timer;
+        timer.start();
+        for (int t = 0; t < threadCount; ++t) {
+            threads.push_back(QThread::create([&]() {
+                DwgThreadScope threadScope;
+                DwgOffscreenRenderer renderer(pDb);
+                QImage image;
+                for (int i = next++; i < keys.size(); i = next++) {
+                    if (!renderer.render(grid.tileRect(keys.at(i)), tileSize, image))
+                        ++failed;
+                }
+            }));
+            threads.back()->start();
+        }
+        for (QThread* thread : threads) {
+            thread->wait();
+            delete thread;
+        }
+        const double ms = timer.nsecsElapsed() / 1.0e6;
+        pDb->setMultiThreadedMode(OdDb::kSTMode);
+
+        const double rate = keys.size() * 1000.0 / qMax(ms, 0.001);
+        if (threadCount == 1 || singleThreadRate <= 0.0)
+            singleThreadRate = rate / threadCount;
+        const double speedup = rate / singleThreadRate;
+
+        QJsonObject run;
+        run["threads"] = threadCount;
+        run["tiles"] = keys.size();
+        run["failed"] = failed.load();
+        run["ms"] = ms;
+        run["tilesPerSecond"] = rate;
+        run["speedup"] = speedup;
+        runs.append(run);
+
+        out << "  " << QString("%1 threads").arg(threadCount).leftJustified(20)
+            << QString::number(ms, 'f', 1).rightJustified(10) << " ms  "
+            << QString::number(rate, 'f', 1).rightJustified(8) << " tuiles/s  x"
+            << QString::number(speedup, 'f', 2) << Qt::endl;
+    }
+    return runs;
+}
+
+// Noyaux de pixels sur une image de 4096 x 4096, hors cache : le débit en
+// Go/s (octets lus + écrits) se compare à la bande passante mémoire
+QJsonArray runKernels(int repetitions, QTextStream& out)
+{
+    const int side = 4096;
+    const qint64 pixels = qint64(side) * side;
+    QByteArray bgr(int(pixels * 3), Qt::Uninitialized);
+    for (int i = 0; i < bgr.size(); ++i)
+        bgr[i] = char((i * 7) ^ (i >> 9));
+    QImage rgb32(side, side, QImage::Format_RGB32);
+    QImage half(side / 2, side / 2, QImage::Format_RGB32);
+    const uchar* src = reinterpret_cast<const uchar*>(bgr.constData());
+
+    struct Kernel
+    {
+        QString name;
+        double bytesPerPixel;       // Lus + écrits, par pixel source
+        std::function<void()> run;
+    };
+    QVector<Kernel> kernels;
+    QList<DwgPixelKernels::Isa> isas { DwgPixelKernels::Scalar };
+    for (DwgPixelKernels::Isa isa : { DwgPixelKernels::Sse2, DwgPixelKernels::Ssse3, DwgPixelKernels::Avx2 }) {
+        if (isa <= DwgPixelKernels::bestIsa())
+            isas << isa;
+    }
+    // Pas de variante SSE2 de la copie BGR (pshufb est SSSE3) : elle serait
+    // mesurée sous ce nom avec le code scalaire
+    for (DwgPixelKernels::Isa isa : isas) {
+        if (isa == DwgPixelKernels::Sse2)
+            continue;
+        kernels.append({ "bgr24ToRgb32/" + DwgPixelKernels::isaName(isa), 3.0 + 4.0, [&, isa]() {
+            for (int y = 0; y < side; ++y)
+                DwgPixelKernels::bgr24ToRgb32(src + qptrdiff(y) * side * 3,
+                                              reinterpret_cast<quint32*>(rgb32.scanLine(y)), side, isa);
+        } });
+    }
+    for (DwgPixelKernels::Isa isa : isas) {
+        kernels.append({ "downsample2x/" + DwgPixelKernels::isaName(isa), 4.0 + 1.0, [&, isa]() {
+            for (int y = 0; y < side / 2; ++y)
+                DwgPixelKernels::downsampleRow2x(reinterpret_cast<const quint32*>(rgb32.constScanLine(2 * y)),
+                                                 reinterpret_cast<const quint32*>(rgb32.constScanLine(2 * y + 1)),
+                                                 reinterpret_cast<quint32*>(half.scanLine(y)), side / 2, isa);
+        } });
+    }
+    // Export TIFF : seules les variantes scalaire et SSSE3 existent
+    QByteArray rgb24(int(pixels * 3), Qt::Uninitialized);
+    for (DwgPixelKernels::Isa isa : isas) {
+        if (isa == DwgPixelKernels::Sse2 || isa == DwgPixelKernels::Avx2)
+            continue;
+        kernels.append({ "rgb32ToRgb24/" + DwgPixelKernels::isaName(isa), 4.0 + 3.0, [&, isa]() {
+            for (int y = 0; y < side; ++y)
+                DwgPixelKernels::rgb32ToRgb24(reinterpret_cast<const quint32*>(rgb32.constScanLine(y)),
+                                              reinterpret_cast<uchar*>(rgb24.data()) + qptrdiff(y) * side * 3, side, isa);
+        } });
+    }
+    // Références : les chemins de Qt qu'ils remplacent
+    kernels.append({ "bgr24ToRgb32/qt", 3.0 + 4.0, [&]() {
+        rgb32 = QImage(src, side, side, side * 3, QImage::Format_BGR888).convertToFormat(QImage::Format_RGB32);
+    } });
+    kernels.append({ "downsample2x/qt", 4.0 + 1.0, [&]() {
+        half = rgb32.scaled(side / 2, side / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    } });
+
+    QJsonArray results;
+    for (const Kernel& kernel : kernels) {
+        kernel.run();   // Échauffement : pages de destination déjà allouées
+        QVector<double> samples;
+        for (int i = 0; i < repetitions; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            kernel.run();
+            samples.append(timer.nsecsElapsed() / 1.0e6);
+        }
+        std::sort(samples.begin(), samples.end());
+        const double medianMs = samples.at(samples.size() / 2);
+        const double mpixPerSecond = pixels / 1.0e6 / (qMax(medianMs, 0.001) / 1000.0);
+        const double gbPerSecond = mpixPerSecond * kernel.bytesPerPixel / 1000.0;
+
+        QJsonObject result;
+        result["kernel"] = kernel.name;
+        result["pixels"] = pixels;
+        result["medianMs"] = medianMs;
+        result["mpixPerSecond"] = mpixPerSecond;
+        result["gbPerSecond"] = gbPerSecond;
+        results.append(result);
+
+        out << "  " << kernel.name.leftJustified(20)
+            << QString::number(medianMs, 'f', 2).rightJustified(10) << " ms  "
+            << QString::number(mpixPerSecond, 'f', 0).rightJustified(8) << " MPix/s  "
+            << QString::number(gbPerSecond, 'f', 1).rightJustified(6) << " Go/s" << Qt::endl;
+    }
+    return results;
+}
+
+QJsonObject summarize(const QVector<double>& values)
+{
+    QVector<double> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    QJsonArray raw;
+    for (double v : values) {
+        sum += v;
+        raw.append(v);
+    }
+
+    QJsonObject stats;
+    if (!sorted.isEmpty()) {
+        const int n = sorted.size();
+        stats["min"] = sorted.first();
+        stats["max"] = sorted.last();
+        stats["mean"] = sum / n;
+        stats["median"] = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+    }
+    stats["samples"] = raw;
+    return stats;
+}
+
+// Compare les médianes avec une exécution de référence ; renvoie le nombre de régressions
+int compareWith(const QJsonObject& current, const QString& baselinePath, double thresholdPercent, QTextStream& out)
+{
+    QFile file(baselinePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "Référence illisible : " << baselinePath << Qt::endl;
+        return 0;
+    }
+    const QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+
+    QMap<QString, QJsonObject> baselineFiles;
+    for (const QJsonValue& value : baseline["files"].toArray())
+        baselineFiles.insert(value.toObject()["path"].toString(), value.toObject()["stages"].toObject());
+
+    int regressions = 0;
+    out << Qt::endl << "Comparaison avec " << baseline["build"].toString() << " (seuil " << thresholdPercent << " %)" << Qt::endl;
+    for (const QJsonValue& value : current["files"].toArray()) {
+        const QJsonObject fileObject = value.toObject();
+        const QString path = fileObject["path"].toString();
+        if (!baselineFiles.contains(path))
+            continue;
+
+        const QJsonObject stages = fileObject["stages"].toObject();
+        const QJsonObject before = baselineFiles.value(path);
+        out << "  " << QFileInfo(path).fileName() << Qt::endl;
+        for (const QString& stage : stages.keys()) {
+            const double oldMedian = before[stage].toObject()["median"].toDouble();
+            const double newMedian = stages[stage].toObject()["median"].toDouble();
+            if (oldMedian <= 0.0)
+                continue;
+            const double change = (newMedian - oldMedian) * 100.0 / oldMedian;
+            const bool regression = change > thresholdPercent;
+            regressions += regression ? 1 : 0;
+            out << "    " << stage.leftJustified(20) << QString::number(oldMedian, 'f', 2).rightJustified(10)
+                << " -> " << QString::number(newMedian, 'f', 2).rightJustified(10) << " ms  "
+                << (change >= 0 ? "+" : "") << QString::number(change, 'f', 1) << " %"
+                << (regression ? "  REGRESSION" : "") << Qt::endl;
+        }
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication a(argc, argv);
+    QCoreApplication::setOrganizationName("stslu");
+    QCoreApplication::setApplicationName("DwgBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Banc de mesure du pipeline de chargement et de rendu DWG.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("corpus", "Fichiers DWG ou dossiers du corpus.", "<fichiers|dossiers...>");
+    QCommandLineOption iterationsOption(QStringList() << "n" << "iterations", "Itérations mesurées par fichier.", "n", "5");
+    QCommandLineOption warmupOption(QStringList() << "w" << "warmup", "Itérations d'échauffement (non mesurées).", "n", "1");
+    QCommandLineOption sizeOption(QStringList() << "s" << "size", "Côté le plus long du rendu, en pixels.", "px", "2048");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Fichier de résultats JSON.", "fichier", "bench.json");
+    QCommandLineOption labelOption(QStringList() << "l" << "label", "Nom de la build mesurée.", "nom", "local");
+    QCommandLineOption compareOption("compare", "Résultats JSON de référence à comparer.", "fichier");
+    QCommandLineOption thresholdOption("threshold", "Seuil de régression sur la médiane, en %.", "pct", "10");
+    QCommandLineOption scalingOption("scaling", "Rendu multithread des tuiles avec ces nombres de threads.",
+                                     "liste", "1,2,4,8,16");
+    QCommandLineOption scalingLevelOption("scaling-level", "Niveau de la pyramide rendu pour --scaling.", "niveau", "3");
+    QCommandLineOption fileInputOption("file-input", "Lecture des fichiers : mapped (projection mémoire) ou buffered.",
+                                       "mode", "mapped");
+    QCommandLineOption allocatorOption("allocator", "Allocations de Teigha : pooled (pools par document) ou system.",
+                                       "mode", "pooled");
+    QCommandLineOption kernelsOption("kernels", "Mesure des noyaux de pixels (le corpus devient facultatif).");
+    parser.addOption(iterationsOption);
+    parser.addOption(warmupOption);
+    parser.addOption(sizeOption);
+    parser.addOption(outputOption);
+    parser.addOption(labelOption);
+    parser.addOption(compareOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(scalingOption);
+    parser.addOption(scalingLevelOption);
+    parser.addOption(fileInputOption);
+    parser.addOption(allocatorOption);
+    parser.addOption(kernelsOption);
+    parser.process(a);
+
+    const QStringList files = collectInputs(parser.positionalArguments());
+    if (files.isEmpty() && !parser.isSet(kernelsOption)) {
+        parser.showHelp(1);
+    }
+
+    // -n 0 : uniquement le passage à l'échelle
+    const int iterations = qMax(0, parser.value(iterationsOption).toInt());
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const int size = qMax(16, parser.value(sizeOption).toInt());
+
+    QList<int> threadCounts;
+    if (parser.isSet(scalingOption)) {
+        for (const QString& value : parser.value(scalingOption).split(',', Qt::SkipEmptyParts)) {
+            if (value.toInt() > 0)
+                threadCounts << value.toInt();
+        }
+    }
+    const int scalingLevel = qBound(0, parser.value(scalingLevelOption).toInt(), DwgTileGrid::kMaxLevel);
+
+    // Comparaison des deux chemins de lecture : une exécution par mode, puis --compare sur readFile
+    const QString fileInput = parser.value(fileInputOption);
+    if (fileInput != "mapped" && fileInput != "buffered")
+        parser.showHelp(1);
+    MyServices::setMappedFileInput(fileInput == "mapped");
+
+    const QString allocator = parser.value(allocatorOption);
+    if (allocator != "pooled" && allocator != "system")
+        parser.showHelp(1);
+    DwgMemory::setPooled(allocator == "pooled");
+
+    // --- Initialisation de Teigha ---
+    initStaticModules();
+    OdStaticRxObject<MyServices> services;
+    g_pServices = &services;
+    odInitialize(&services);
+
+    QTextStream out(stdout);
+    QJsonArray fileResults;
+    int failures = 0;
+
+    QJsonArray kernelResults;
+    if (parser.isSet(kernelsOption)) {
+        out << "Noyaux de pixels (" << DwgPixelKernels::isaName(DwgPixelKernels::bestIsa()) << ")" << Qt::endl;
+        kernelResults = runKernels(qMax(1, iterations), out);
+    }
+
+    for (const QString& path : files) {
+        out << path << Qt::endl;
+        StageSamples samples;
+        DwgMemoryStats memory;
+        QJsonArray scaling;
+        try
+        {
+            for (int i = 0; i < (iterations > 0 ? warmup : 0); ++i) {
+                StageSamples ignored;
+                runIteration(path, size, ignored, memory);
+            }
+            for (int i = 0; i < iterations; ++i)
+                runIteration(path, size, samples, memory);
+            if (!threadCounts.isEmpty())
+                scaling = runScaling(path, threadCounts, scalingLevel, out);
+        }
+        catch (const OdError& e)
+        {
+            out << "  FAIL " << QString::fromWCharArray((const wchar_t*)e.description().c_str()) << Qt::endl;
+            ++failures;
+            continue;
+        }
+        catch (const std::exception& ex)
+        {
+            out << "  FAIL " << ex.what() << Qt::endl;
+            ++failures;
+            continue;
+        }
+
+        QJsonObject stages;
+        for (const char* stage : kStages) {
+            if (iterations == 0)
+                break;
+            const QJsonObject stats = summarize(samples.value(stage));
+            stages[stage] = stats;
+            out << "  " << QString(stage).leftJustified(20)
+                << " médiane " << QString::number(stats["median"].toDouble(), 'f', 2).rightJustified(10) << " ms"
+                << "   min " << QString::number(stats["min"].toDouble(), 'f', 2).rightJustified(10) << " ms" << Qt::endl;
+        }
+
+        QJsonObject fileObject;
+        fileObject["path"] = path;
+        fileObject["bytes"] = QFileInfo(path).size();
+        fileObject["stages"] = stages;
+        if (iterations > 0)
+            fileObject["memory"] = memoryToJson(memory);
+        if (!scaling.isEmpty())
+            fileObject["scaling"] = scaling;
+        fileObject["rssAfterBytes"] = ProcessMemory::currentRss();
+        fileResults.append(fileObject);
+    }
+
+    // --- Nettoyage de Teigha ---
+    odUninitialize();
+    g_pServices = nullptr;
+
+    QJsonObject results;
+    results["build"] = parser.value(labelOption);
+    results["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    results["host"] = QSysInfo::machineHostName();
+    results["cpu"] = QSysInfo::currentCpuArchitecture();
+    results["qt"] = QString(qVersion());
+    results["iterations"] = iterations;
+    results["warmup"] = warmup;
+    results["size"] = size;
+    results["fileInput"] = fileInput;
+    results["allocator"] = allocator;
+    results["peakRssBytes"] = ProcessMemory::peakRss();
+    results["files"] = fileResults;
+    if (!kernelResults.isEmpty())
+        results["kernels"] = kernelResults;
+
+    const QString outputPath = parser.value(outputOption);
+    QFile output(outputPath);
+    if (output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        output.write(QJsonDocument(results).toJson());
+        out << Qt::endl << "Résultats : " << outputPath << Qt::endl;
+    } else {
+        out << Qt::endl << "Écriture impossible : " << outputPath << Qt::endl;
+    }
+    out << "Mémoire crête : " << ProcessMemory::peakRss() / (1024 * 1024) << " Mo" << Qt::endl;
+
+    int regressions = 0;
+    if (parser.isSet(compareOption))
+        regressions = compareWith(results, parser.value(compareOption), parser.value(thresholdOption).toDouble(), out);
+
+    if (failures > 0)
+        return 2;
+    return regressions > 0 ? 3 : 0;
+}
@@ -3,34 +3,10 @@
 #include "MyServices.h" // On inclut notre nouvelle classe
 #include <QApplication>
 #include "StaticRxObject.h"
-
-// doit être dans le cpp où se trouve odInitialize
-
-// Headers requis pour les macros statiques
-#include <RxDynamicModule.h>
-#include <OdModuleNames.h>
-
-// 1. DÉCLARATIONS
-ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(OdRecomputeDimBlockModule);
-ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(WinGDIModule);
-ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(BitmapModule);
-ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(WinOpenGLModule);
-ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(ModelerModule);      // CRITIQUE pour les plans avec 3D
-ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(ExRasterModule);     // CRITIQUE pour les images/logos
-ODRX_DECLARE_STATIC_MODULE_ENTRY_POINT(OdRasterProcessingServicesImpl);
-
-// 2. MAP
-ODRX_BEGIN_STATIC_MODULE_MAP()
-ODRX_DEFINE_STATIC_APPMODULE(OdWinOpenGLModuleName, WinOpenGLModule)
-ODRX_DEFINE_STATIC_APPMODULE(OdWinBitmapModuleName, BitmapModule)
-ODRX_DEFINE_STATIC_APPMODULE(OdRecomputeDimBlockModuleName, OdRecomputeDimBlockModule)
-ODRX_DEFINE_STATIC_APPMODULE(OdWinGDIModuleName, WinGDIModule)
-// Modules additionnels pour éviter les crashs sur entités complexes
-ODRX_DEFINE_STATIC_APPMODULE(OdModelerGeometryModuleName, ModelerModule)
-ODRX_DEFINE_STATIC_APPMODULE(RX_RASTER_SERVICES_APPNAME, ExRasterModule)
-ODRX_DEFINE_STATIC_APPMODULE(OdRasterProcessorModuleName, OdRasterProcessingServicesImpl)
-ODRX_END_STATIC_MODULE_MAP()
-
+#include "StaticModules.h"
+#include "DwgMemory.h"
+#include "DwgTrace.h"
+#include <QSettings>
 
 int main(int argc, char *argv[])
 {
@@ -38,11 +14,19 @@ int main(int argc, char *argv[])
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 
     QApplication a(argc, argv);
+    // Utilisés par QSettings (réglages du cache disque, etc.)
+    QCoreApplication::setOrganizationName("stslu");
+    QCoreApplication::setApplicationName("DwgViewerGs");
+
+    // Traçage du pipeline : DWG_TRACE=1 ou bouton "Trace" de la barre d'outils
+    DwgTrace::initFromEnvironment();
+
+    // Pools de DwgMemory ou tas système pour les allocations de Teigha (comparaison)
+    DwgMemory::setPooled(QSettings().value("memory/pooled", true).toBool());
 
     // --- Initialisation de Teigha ---
     // avant odInitialize
-    // Enregistre les modules déclarés plus haut (comme RecomputeDimBlock)
-    ODRX_INIT_STATIC_MODULE_MAP();
+    initStaticModules();
 
     // On utilise OdStaticRxObject pour créer l'objet sur la pile (stack)
     // Cela évite les erreurs "cannot instantiate abstract class"
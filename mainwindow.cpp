@@ -1,14 +1,46 @@
 #include "mainwindow.h"
+#include "DwgGraphicsView.h"
+#include "DwgLayoutBrowser.h"
+#include "DwgLiveReload.h"
+#include "DwgLoader.h"
+#include "DwgMemory.h"
 #include "DwgRendererItem.h"
+#include "DwgStripExport.h"
+#include "DwgTextIndex.h"
+#include "DwgThreadScope.h"
+#include "DwgTrace.h"
 
+#include <QAction>
+#include <QDebug>
+#include <QDockWidget>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
 #include <QToolBar>
 #include <QPushButton>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QGraphicsPixmapItem>
+#include <QGraphicsRectItem>
+#include <QInputDialog>
 #include <QMessageBox>
-#include <QOpenGLWidget>
-#include <QSurfaceFormat>
+#include <QProgressBar>
+#include <QSettings>
+#include <QSignalBlocker>
+#include <QStatusBar>
+#include <QThread>
+#include <QTimer>
+#include <QVBoxLayout>
 
 #include "MyServices.h"
+#include "ProcessMemory.h"
+
+#include "DbLayerTable.h"
+#include "DbLayerTableRecord.h"
+#include "DbSymbolTable.h"
+
+// Présentations quittées dont les tuiles restent en mémoire
+static const int kLayoutTileCacheCount = 3;
 
 // // Includes Teigha pour charger le fichier
 // #include "Extensions/ExServices/ExSystemServices.h"
@@ -24,9 +56,17 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    // Le OdDbDatabasePtr se nettoie automatiquement
+    // Arrête le rendu (les items référencent la base) puis les lectures en cours
+    stopImageExport();
+    stopTextIndex();
+    m_liveReload->setFile(QString());
+    m_scene->clear();
+    m_layoutBrowser->setDatabase(OdDbDatabasePtr());
+    m_loader->cancel();
+    DwgLoader::waitForBackgroundWork();
+
     // Forcer la libération de la base de données avant la fermeture
-    m_pDb.release();
+    MyServices::closeDatabase(m_pDb);
 }
 
 void MainWindow::setupUi()
@@ -36,31 +76,18 @@ void MainWindow::setupUi()
 
     m_scene = new QGraphicsScene(this);
 
-    m_view = new QGraphicsView(m_scene);
+    // Viewport OpenGL ou défilement raster : voir DwgGraphicsView
+    m_scrollingMode = QSettings().value("view/scrolling", false).toBool();
+    m_view = new DwgGraphicsView(m_scene, m_scrollingMode);
 
-    m_view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
     m_view->setResizeAnchor(QGraphicsView::AnchorUnderMouse);
     m_view->setRenderHint(QPainter::Antialiasing, true);
     m_view->setRenderHint(QPainter::SmoothPixmapTransform, true);
 
     //vl : ajouter le zoom avec Ctrl+Molette
-    m_view->setDragMode(QGraphicsView::ScrollHandDrag);
-
-
-    // Configuration OpenGL
-    QOpenGLWidget* openGlWidget = new QOpenGLWidget();
-    QSurfaceFormat format;
-    format.setSamples(4);
-    format.setDepthBufferSize(24); // Important pour la 3D
-    format.setStencilBufferSize(8);
-    openGlWidget->setFormat(format);
-
-    m_view->setViewport(openGlWidget);
-    m_view->setRenderHint(QPainter::Antialiasing, true);
     // m_view->setDragMode(QGraphicsView::ScrollHandDrag);
     m_view->setDragMode(QGraphicsView::NoDrag);
     m_view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
-    m_view->setViewportUpdateMode(QGraphicsView::FullViewportUpdate); // Important pour OpenGL
 
     setCentralWidget(m_view);
 
@@ -68,6 +95,268 @@ void MainWindow::setupUi()
     QPushButton* openButton = new QPushButton("Ouvrir un fichier DWG", this);
     connect(openButton, &QPushButton::clicked, this, &MainWindow::openDwgFile);
     toolBar->addWidget(openButton);
+
+    // Avancement de la lecture dans la barre d'état
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setRange(0, 100);
+    m_progressBar->setMaximumWidth(240);
+    m_cancelButton = new QPushButton("Annuler", this);
+    statusBar()->addPermanentWidget(m_progressBar);
+    statusBar()->addPermanentWidget(m_cancelButton);
+    showLoadProgress(false);
+
+    // Durée des images de la vue, relevée chaque seconde où quelque chose a été peint
+    m_frameStatsLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_frameStatsLabel);
+    QTimer* frameStatsTimer = new QTimer(this);
+    connect(frameStatsTimer, &QTimer::timeout, this, &MainWindow::reportFrameStats);
+    frameStatsTimer->start(1000);
+
+    m_loader = new DwgLoader(this);
+    m_liveReload = new DwgLiveReload(this);
+
+    // Panneau des calques : masquer un calque ne revectorise pas les autres
+    m_layerList = new QListWidget(this);
+    m_layerList->setSortingEnabled(true);
+    connect(m_layerList, &QListWidget::itemChanged, this, &MainWindow::onLayerItemChanged);
+    QDockWidget* layerDock = new QDockWidget("Calques", this);
+    layerDock->setObjectName("layers");
+    layerDock->setWidget(m_layerList);
+    addDockWidget(Qt::RightDockWidgetArea, layerDock);
+
+    // Panneau des présentations : vignettes rendues au fil du défilement
+    m_layoutBrowser = new DwgLayoutBrowser(this);
+    connect(m_layoutBrowser, &DwgLayoutBrowser::layoutActivated, this, &MainWindow::onLayoutActivated);
+    QDockWidget* layoutDock = new QDockWidget("Présentations", this);
+    layoutDock->setObjectName("layouts");
+    layoutDock->setWidget(m_layoutBrowser);
+    addDockWidget(Qt::RightDockWidgetArea, layoutDock);
+
+    // Panneau de recherche : préfixes puis sous-chaînes, un clic cadre le texte
+    QWidget* findPanel = new QWidget(this);
+    QVBoxLayout* findLayout = new QVBoxLayout(findPanel);
+    findLayout->setContentsMargins(0, 0, 0, 0);
+    m_findEdit = new QLineEdit(findPanel);
+    m_findEdit->setClearButtonEnabled(true);
+    m_findEdit->setPlaceholderText("Rechercher un texte");
+    m_findEdit->setEnabled(false);
+    m_findResults = new QListWidget(findPanel);
+    m_findStatus = new QLabel(findPanel);
+    findLayout->addWidget(m_findEdit);
+    findLayout->addWidget(m_findResults);
+    findLayout->addWidget(m_findStatus);
+    connect(m_findEdit, &QLineEdit::textChanged, this, &MainWindow::onFindTextChanged);
+    connect(m_findEdit, &QLineEdit::returnPressed, this, [this]() {
+        if (m_findResults->count() > 0)
+            onFindResultActivated(m_findResults->item(0));
+    });
+    connect(m_findResults, &QListWidget::itemActivated, this, &MainWindow::onFindResultActivated);
+    connect(m_findResults, &QListWidget::itemClicked, this, &MainWindow::onFindResultActivated);
+    QDockWidget* findDock = new QDockWidget("Recherche", this);
+    findDock->setObjectName("find");
+    findDock->setWidget(findPanel);
+    addDockWidget(Qt::RightDockWidgetArea, findDock);
+
+    QAction* findAction = new QAction("Rechercher", this);
+    findAction->setShortcut(QKeySequence::Find);
+    connect(findAction, &QAction::triggered, this, [this, findDock]() {
+        findDock->show();
+        findDock->raise();
+        m_findEdit->setFocus();
+        m_findEdit->selectAll();
+    });
+    addAction(findAction);
+
+    // Ouverture rapide (chargement partiel) : mémorisée d'une session à l'autre
+    QAction* partialLoadAction = toolBar->addAction("Ouverture rapide");
+    partialLoadAction->setCheckable(true);
+    partialLoadAction->setToolTip("Chargement partiel : les objets sont lus à la demande pendant le rendu");
+    partialLoadAction->setChecked(QSettings().value("load/partial", false).toBool());
+    m_loader->setPartialLoad(partialLoadAction->isChecked());
+    m_liveReload->setPartialLoad(partialLoadAction->isChecked());
+    connect(partialLoadAction, &QAction::toggled, this, [this](bool checked) {
+        m_loader->setPartialLoad(checked);
+        m_liveReload->setPartialLoad(checked);
+        QSettings().setValue("load/partial", checked);
+    });
+
+    // Traçage (et images de débogage) : export Chrome trace / Perfetto à la demande
+    QAction* traceAction = toolBar->addAction("Trace");
+    traceAction->setCheckable(true);
+    traceAction->setToolTip("Enregistre la durée des étapes de chargement et de rendu");
+    traceAction->setChecked(DwgTrace::isEnabled() || QSettings().value("trace/enabled", false).toBool());
+    DwgTrace::setEnabled(traceAction->isChecked());
+    connect(traceAction, &QAction::toggled, this, [](bool checked) {
+        DwgTrace::setEnabled(checked);
+        QSettings().setValue("trace/enabled", checked);
+    });
+    // Mode vectoriel : zoom sans flou ni nouveau rendu, mémorisé d'une session à l'autre
+    QAction* vectorAction = toolBar->addAction("Vectoriel");
+    vectorAction->setCheckable(true);
+    vectorAction->setToolTip("Rejoue une liste d'affichage vectorielle au lieu des tuiles raster");
+    m_vectorMode = QSettings().value("view/vector", false).toBool();
+    vectorAction->setChecked(m_vectorMode);
+    connect(vectorAction, &QAction::toggled, this, [this](bool checked) {
+        m_vectorMode = checked;
+        QSettings().setValue("view/vector", checked);
+        if (m_dwgItem)
+            m_dwgItem->setVectorMode(checked);
+    });
+
+    // Défilement : viewport raster, seules les bandes découvertes sont repeintes
+    // et les tuiles sont pré-mises à l'échelle ; mémorisé d'une session à l'autre
+    QAction* scrollingAction = toolBar->addAction("Défilement");
+    scrollingAction->setCheckable(true);
+    scrollingAction->setToolTip("Déplacement par défilement du contenu affiché (sans OpenGL)");
+    scrollingAction->setChecked(m_scrollingMode);
+    connect(scrollingAction, &QAction::toggled, this, [this](bool checked) {
+        m_scrollingMode = checked;
+        QSettings().setValue("view/scrolling", checked);
+        m_view->setScrollingMode(checked);
+        if (m_dwgItem)
+            m_dwgItem->setPrescaledTiles(checked);
+    });
+
+    QAction* memoryAction = toolBar->addAction("Mémoire...");
+    memoryAction->setToolTip("Mémoire allouée par Teigha, par document");
+    connect(memoryAction, &QAction::triggered, this, &MainWindow::showMemoryStats);
+
+    QAction* exportImageAction = toolBar->addAction("Exporter l'image...");
+    exportImageAction->setToolTip("Export TIFF grand format, rendu et écrit par bandes");
+    connect(exportImageAction, &QAction::triggered, this, &MainWindow::exportImage);
+
+    QAction* exportTraceAction = toolBar->addAction("Exporter la trace...");
+    connect(exportTraceAction, &QAction::triggered, this, &MainWindow::exportTrace);
+
+    connect(m_cancelButton, &QPushButton::clicked, m_loader, &DwgLoader::cancel);
+    connect(m_cancelButton, &QPushButton::clicked, this, [this]() { showLoadProgress(false); });
+    connect(m_loader, &DwgLoader::progress, this, &MainWindow::onLoadProgress);
+    connect(m_loader, &DwgLoader::previewReady, this, &MainWindow::onPreviewReady);
+    connect(m_loader, &DwgLoader::loaded, this, &MainWindow::onDwgLoaded);
+    connect(m_loader, &DwgLoader::failed, this, &MainWindow::onLoadFailed);
+    connect(m_loader, &DwgLoader::cancelled, this, &MainWindow::onLoadCancelled);
+    connect(m_liveReload, &DwgLiveReload::fileModified, this, &MainWindow::onFileModified);
+    connect(m_liveReload, &DwgLiveReload::reloaded, this, &MainWindow::onDocumentReloaded);
+    connect(m_liveReload, &DwgLiveReload::reloadFailed, this, [this](const QString&, const QString& message) {
+        statusBar()->showMessage("Rechargement impossible : " + message, 5000);
+    });
+}
+
+void MainWindow::showLoadProgress(bool visible)
+{
+    m_progressBar->setVisible(visible);
+    m_cancelButton->setVisible(visible);
+    if (visible)
+        m_progressBar->setValue(0);
+    else
+        statusBar()->clearMessage();
+}
+
+void MainWindow::closeDocument()
+{
+    // Les items (et leur thread de rendu) doivent disparaître avant la base
+    stopImageExport();
+    stopTextIndex();
+    m_liveReload->setFile(QString());
+    m_scene->clear();
+    m_layoutTiles.clear();
+    m_findMarker = nullptr;
+    m_textIndex.reset();
+    m_findResults->clear();
+    m_findEdit->setEnabled(false);
+    m_findStatus->clear();
+    m_layoutBrowser->setDatabase(OdDbDatabasePtr());
+    m_previewItem = nullptr;
+    m_preview = QImage();
+    m_previewMs = -1;
+    m_layerList->clear();
+    DwgLoader::releaseInBackground(m_pDb);
+}
+
+void MainWindow::populateLayers()
+{
+    // Lu avant la création de l'item : aucun thread de rendu n'utilise encore la base
+    QSignalBlocker blocker(m_layerList);
+    m_layerList->clear();
+    if (m_pDb.isNull())
+        return;
+
+    OdDbLayerTablePtr pLayers = m_pDb->getLayerTableId().safeOpenObject();
+    for (OdDbSymbolTableIteratorPtr it = pLayers->newIterator(); !it->done(); it->step()) {
+        OdDbLayerTableRecordPtr pLayer = it->getRecordId().safeOpenObject();
+        QListWidgetItem* item = new QListWidgetItem(QString::fromWCharArray((const wchar_t*)pLayer->getName().c_str()));
+        if (pLayer->isOff() || pLayer->isFrozen()) {
+            // Absents de la vectorisation : rien à réafficher
+            item->setFlags(item->flags() & ~Qt::ItemIsEnabled);
+            item->setCheckState(Qt::Unchecked);
+            item->setToolTip("Calque désactivé ou gelé dans le dessin");
+        } else {
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(Qt::Checked);
+        }
+        m_layerList->addItem(item);
+    }
+}
+
+void MainWindow::onLayerItemChanged(QListWidgetItem* item)
+{
+    if (m_dwgItem && (item->flags() & Qt::ItemIsEnabled))
+        m_dwgItem->setLayerVisible(item->text(), item->checkState() == Qt::Checked);
+}
+
+void MainWindow::onLayoutActivated(const QString& handle, const QString& name)
+{
+    const OdDbObjectId layoutId = m_layoutBrowser->layoutId(handle);
+    if (m_pDb.isNull() || layoutId.isNull() || layoutId == m_pDb->currentLayoutId())
+        return;
+
+    // Changer la présentation active modifie la base : plus aucun thread ne
+    // doit la lire (vignettes en cours, threads de tuiles de l'item)
+    stopImageExport();
+    stopTextIndex();
+    m_layoutBrowser->waitForIdle();
+
+    // Tuiles de la présentation quittée, gardées pour un retour
+    if (m_dwgItem) {
+        const OdString leftHandle = m_pDb->currentLayoutId().getHandle().ascii();
+        if (DwgTileSnapshotPtr snapshot = m_dwgItem->tileSnapshot()) {
+            m_layoutTiles.prepend(qMakePair(QString::fromWCharArray((const wchar_t*)leftHandle.c_str()), snapshot));
+            while (m_layoutTiles.size() > kLayoutTileCacheCount)
+                m_layoutTiles.removeLast();
+        }
+    }
+    delete m_dwgItem;
+
+    QString currentHandle = handle;
+    try {
+        m_pDb->setCurrentLayout(layoutId);
+    } catch (const OdError& e) {
+        const QString message = QString::fromWCharArray((const wchar_t*)e.description().c_str());
+        qWarning() << "Layout switch failed:" << message;
+        statusBar()->showMessage("Changement de présentation impossible : " + message, 5000);
+        const OdString previous = m_pDb->currentLayoutId().getHandle().ascii();
+        currentHandle = QString::fromWCharArray((const wchar_t*)previous.c_str());
+    }
+    m_layoutBrowser->setCurrentLayout(currentHandle);
+    // Les emprises des textes dépendent de la présentation
+    startTextIndex();
+
+    // Tuiles encore en mémoire si la présentation a été affichée récemment ;
+    // sinon le cache disque, indexé par présentation, évite les nouveaux
+    // rendus. La vignette sert d'aperçu en attendant la tuile racine
+    DwgRendererItem* dwgItem = createRendererItem(m_layoutBrowser->thumbnail(currentHandle));
+    for (int i = 0; i < m_layoutTiles.size(); ++i) {
+        if (m_layoutTiles.at(i).first != currentHandle)
+            continue;
+        const DwgTileSnapshotPtr snapshot = m_layoutTiles.takeAt(i).second;
+        if (snapshot->index)
+            dwgItem->setSpatialIndex(snapshot->index);
+        dwgItem->adoptTiles(*snapshot, QVector<QRectF>(), false);
+        break;
+    }
+    m_view->centerOn(dwgItem);
+    if (currentHandle == handle)
+        statusBar()->showMessage("Présentation : " + name, 3000);
 }
 
 void MainWindow::openDwgFile()
@@ -75,39 +364,438 @@ void MainWindow::openDwgFile()
     QString filePath = QFileDialog::getOpenFileName(this, "Ouvrir", "", "Fichiers AutoCAD (*.dwg)");
     if (filePath.isEmpty()) return;
 
-    m_scene->clear();
-    m_pDb.release();
+    closeDocument();
 
-    try
-    {
-        if (!g_pServices) throw std::runtime_error("Services Teigha non initialisés.");
+    // La lecture se fait en arrière-plan : l'item est créé dans onDwgLoaded()
+    showLoadProgress(true);
+    statusBar()->showMessage("Chargement de " + filePath);
+    m_openTimer.start();
+    m_loader->load(filePath);
+}
 
-        // Utilisation du service global pour lire le fichier
-        // Cast explicite vers wchar_t* pour être sûr
-        m_pDb = g_pServices->readFile((const wchar_t*)filePath.toStdWString().c_str());
+void MainWindow::onLoadProgress(const QString& stage, int percent)
+{
+    if (!stage.isEmpty())
+        statusBar()->showMessage(stage);
+    m_progressBar->setValue(percent);
+}
+
+void MainWindow::onPreviewReady(const QString& filePath, const QImage& image)
+{
+    Q_UNUSED(filePath);
+    // Premier visuel : l'aperçu enregistré dans le fichier, en attendant la base
+    m_previewMs = m_openTimer.elapsed();
+    m_preview = image;
+    delete m_previewItem;
+    m_previewItem = m_scene->addPixmap(QPixmap::fromImage(image));
+    m_view->centerOn(m_previewItem);
+}
 
-        if (m_pDb.isNull()) throw std::runtime_error("Impossible de lire le fichier DWG.");
+void MainWindow::onDwgLoaded(const QString& filePath, OdDbDatabasePtr pDb)
+{
+    showLoadProgress(false);
+
+    m_loadMs = m_openTimer.elapsed();
+    m_pDb = pDb;
+
+    try {
+        populateLayers();
+    } catch (const OdError& e) {
+        qWarning() << "Layer table error:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
     }
-    catch (const OdError& e)
-    {
-        QString msg = QString::fromWCharArray((const wchar_t*)e.description().c_str());
-        QMessageBox::critical(this, "Erreur Teigha", "Erreur de chargement :\n" + msg);
+    m_layoutBrowser->setDatabase(m_pDb);
+    startTextIndex();
+
+    // L'item reprend l'aperçu, étiré sur l'emprise du dessin, sous ses tuiles
+    delete m_previewItem;
+    m_previewItem = nullptr;
+
+    DwgRendererItem* dwgItem = createRendererItem(m_preview);
+    connect(dwgItem, &DwgRendererItem::firstFramePainted, this, &MainWindow::onFirstFramePainted);
+
+    QGraphicsSimpleTextItem* annotation = new QGraphicsSimpleTextItem("Annotation Qt");
+    annotation->setPos(0, 0);
+    annotation->setBrush(Qt::red);
+    annotation->setFont(QFont("Arial", 50, QFont::Bold));
+    m_scene->addItem(annotation);
+
+    m_liveReload->setFile(filePath);
+}
+
+void MainWindow::onFileModified(const QString& filePath)
+{
+    if (m_pDb.isNull() || !m_dwgItem)
+        return;
+
+    // Comparée à l'index de l'item affiché (nul s'il n'est pas encore prêt : tout sera rendu)
+    const OdString layoutHandle = m_pDb->currentLayoutId().getHandle().ascii();
+    statusBar()->showMessage("Fichier modifié, rechargement de " + filePath);
+    m_liveReload->reload(m_dwgItem->spatialIndex(), QString::fromWCharArray((const wchar_t*)layoutHandle.c_str()));
+}
+
+void MainWindow::onDocumentReloaded(const QString& filePath, OdDbDatabasePtr pDb, const DwgSpatialIndexPtr& index,
+                                    const QVector<QRectF>& changedRegions, bool allChanged)
+{
+    if (m_pDb.isNull() || !m_dwgItem) {
+        DwgLoader::releaseInBackground(pDb);
         return;
     }
-    catch (const std::exception& ex)
+
+    // Plus aucun lecteur de l'ancienne base hors de son item
+    stopImageExport();
+    stopTextIndex();
+    m_layoutBrowser->waitForIdle();
+
+    QSet<QString> hiddenLayers;
+    for (int i = 0; i < m_layerList->count(); ++i) {
+        QListWidgetItem* item = m_layerList->item(i);
+        if ((item->flags() & Qt::ItemIsEnabled) && item->checkState() != Qt::Checked)
+            hiddenLayers.insert(item->text());
+    }
+
+    // Échange d'un bloc : le nouvel item reprend les tuiles de l'ancien, les
+    // zones modifiées restent affichées jusqu'à leur nouveau rendu
+    DwgRendererItem* previous = m_dwgItem;
+    OdDbDatabasePtr previousDb = m_pDb;
+    m_pDb = pDb;
+    try {
+        populateLayers();
+    } catch (const OdError& e) {
+        qWarning() << "Layer table error:" << QString::fromWCharArray((const wchar_t*)e.description().c_str());
+    }
     {
-        QMessageBox::critical(this, "Erreur", QString("Erreur système : %1").arg(ex.what()));
-        return;
+        QSignalBlocker blocker(m_layerList);
+        for (int i = 0; i < m_layerList->count(); ++i) {
+            QListWidgetItem* item = m_layerList->item(i);
+            if ((item->flags() & Qt::ItemIsEnabled) && hiddenLayers.contains(item->text()))
+                item->setCheckState(Qt::Unchecked);
+        }
     }
 
+    // Vignettes et index de texte avant l'item : le mode multithread de la
+    // nouvelle base est acquis avant que ses threads de tuiles ne démarrent
+    m_layoutBrowser->setDatabase(m_pDb);
+    startTextIndex();
+
+    // Les tuiles des autres présentations montrent l'ancienne version
+    m_layoutTiles.clear();
+    DwgRendererItem* dwgItem = createRendererItem(QImage());
+    if (index)
+        dwgItem->setSpatialIndex(index);
+    if (const DwgTileSnapshotPtr snapshot = previous->tileSnapshot())
+        dwgItem->adoptTiles(*snapshot, changedRegions, allChanged);
+    delete previous;
+    DwgLoader::releaseInBackground(previousDb);
+
+    const QString changes = allChanged ? QString("tout le dessin est rendu de nouveau")
+                                       : QString("%1 zones modifiées").arg(changedRegions.size());
+    statusBar()->showMessage(QString("Rechargé : %1 (%2)").arg(QFileInfo(filePath).fileName(), changes), 5000);
+}
+
+DwgRendererItem* MainWindow::createRendererItem(const QImage& preview)
+{
     DwgRendererItem* dwgItem = new DwgRendererItem(m_pDb);
+    connect(dwgItem, &DwgRendererItem::entityHovered, this, &MainWindow::onEntityHovered);
+    dwgItem->setVectorMode(m_vectorMode);
+    dwgItem->setPrescaledTiles(m_scrollingMode);
+    dwgItem->setPreview(preview);
+    // Calques déjà masqués dans le panneau (changement de présentation)
+    for (int i = 0; i < m_layerList->count(); ++i) {
+        QListWidgetItem* item = m_layerList->item(i);
+        if ((item->flags() & Qt::ItemIsEnabled) && item->checkState() != Qt::Checked)
+            dwgItem->setLayerVisible(item->text(), false);
+    }
     m_scene->addItem(dwgItem);
+    m_dwgItem = dwgItem;
+    return dwgItem;
+}
 
-    QGraphicsSimpleTextItem* annotation = new QGraphicsSimpleTextItem("Annotation Qt");
-    annotation->setPos(0, 0);
-    annotation->setBrush(Qt::red);
-    annotation->setFont(QFont("Arial", 50, QFont::Bold));
-    m_scene->addItem(annotation);
+void MainWindow::onLoadFailed(const QString& filePath, const QString& title, const QString& message)
+{
+    Q_UNUSED(filePath);
+    showLoadProgress(false);
+    delete m_previewItem;
+    m_previewItem = nullptr;
+    QMessageBox::critical(this, title, message);
+}
+
+void MainWindow::onLoadCancelled(const QString& filePath)
+{
+    showLoadProgress(false);
+    delete m_previewItem;
+    m_previewItem = nullptr;
+    statusBar()->showMessage("Chargement annulé : " + filePath, 3000);
+}
+
+void MainWindow::onFirstFramePainted()
+{
+    // Comparaison chargement partiel / complet : temps jusqu'à la première image et mémoire résidente
+    const qint64 firstFrameMs = m_openTimer.elapsed();
+    const qint64 rssMb = ProcessMemory::currentRss() / (1024 * 1024);
+    const QString mode = m_loader->partialLoad() ? "partiel" : "complet";
+
+    const QString preview = m_previewMs >= 0 ? QString("aperçu %1 ms, ").arg(m_previewMs) : QString();
+    const QString report = QString("Chargement %1 : %2lecture %3 ms, première image %4 ms, mémoire %5 Mo")
+                               .arg(mode, preview).arg(m_loadMs).arg(firstFrameMs).arg(rssMb);
+    qInfo().noquote() << report;
+    statusBar()->showMessage(report, 10000);
+}
+
+void MainWindow::reportFrameStats()
+{
+    const DwgFrameStats stats = m_view->takeFrameStats();
+    if (stats.frames == 0)
+        return;
+
+    m_frameStatsLabel->setText(QString("%1 img/s, médiane %2 ms, p95 %3 ms, max %4 ms")
+                                   .arg(stats.framesPerSecond, 0, 'f', 0)
+                                   .arg(stats.medianMs, 0, 'f', 1)
+                                   .arg(stats.p95Ms, 0, 'f', 1)
+                                   .arg(stats.maxMs, 0, 'f', 1));
+    if (DwgTrace::isEnabled())
+        qInfo().noquote() << "Frames:" << m_frameStatsLabel->text();
+}
+
+void MainWindow::showMemoryStats()
+{
+    QString text = QString("Allocateur : %1\n").arg(DwgMemory::isPooled() ? "pools par document" : "tas système");
+    for (const DwgMemoryStats& stats : DwgMemory::allStats()) {
+        text += QString("\n%1%2\n  courant %3 Mo, crête %4 Mo, pages %5 Mo\n  %6 allocations, %7 libérations\n")
+                    .arg(stats.name, stats.closed ? " (fermé)" : "")
+                    .arg(stats.currentBytes / (1024.0 * 1024.0), 0, 'f', 1)
+                    .arg(stats.peakBytes / (1024.0 * 1024.0), 0, 'f', 1)
+                    .arg(stats.reservedBytes / (1024.0 * 1024.0), 0, 'f', 1)
+                    .arg(stats.allocations).arg(stats.frees);
+        for (const DwgSizeClassStats& sizeClass : stats.sizeClasses) {
+            if (sizeClass.allocations == 0)
+                continue;
+            const QString size = sizeClass.size > 0 ? QString("%1 o").arg(sizeClass.size) : QString("> 1 Ko");
+            text += QString("    %1 : %2 vivants / %3\n").arg(size).arg(sizeClass.live).arg(sizeClass.allocations);
+        }
+    }
+    QMessageBox::information(this, "Mémoire", text);
+}
+
+void MainWindow::exportTrace()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "Exporter la trace", "dwgviewer-trace.json",
+                                                    "Chrome trace (*.json)");
+    if (filePath.isEmpty()) return;
+
+    if (DwgTrace::exportChromeTrace(filePath))
+        statusBar()->showMessage("Trace exportée : " + filePath, 5000);
+    else
+        QMessageBox::warning(this, "Trace", "Écriture impossible :\n" + filePath);
+}
+
+void MainWindow::exportImage()
+{
+    if (m_pDb.isNull() || !m_dwgItem)
+        return;
+    if (m_exportThread) {
+        statusBar()->showMessage("Un export est déjà en cours", 3000);
+        return;
+    }
+
+    const QString filePath = QFileDialog::getSaveFileName(this, "Exporter l'image", "", "Image TIFF (*.tif *.tiff)");
+    if (filePath.isEmpty()) return;
+
+    QSettings settingsStore;
+    const QStringList papers = { "A0", "A1", "A2", "A3", "A4" };
+    bool ok = false;
+    const QString paper = QInputDialog::getItem(this, "Exporter l'image", "Format de la feuille :", papers,
+                                                qMax(0, papers.indexOf(settingsStore.value("export/paper", "A0").toString())),
+                                                false, &ok);
+    if (!ok) return;
+    const int dpi = QInputDialog::getInt(this, "Exporter l'image", "Résolution (dpi) :",
+                                         settingsStore.value("export/dpi", 300).toInt(), 72, 2400, 1, &ok);
+    if (!ok) return;
+    settingsStore.setValue("export/paper", paper);
+    settingsStore.setValue("export/dpi", dpi);
+
+    DwgStripExportSettings settings;
+    settings.region = m_dwgItem->boundingRect();
+    settings.dpi = dpi;
+    settings.size = DwgStripExport::fitToPaper(settings.region, DwgStripExport::paperSizeMm(paper), dpi);
+    if (settings.size.isEmpty()) {
+        statusBar()->showMessage("Emprise du dessin invalide : export impossible", 5000);
+        return;
+    }
+
+    // Les threads de tuiles et de vignettes lisent la base en même temps :
+    // mode multithread acquis ici, tant qu'aucun nouveau lecteur ne démarre
+    m_exportMultiThreaded.reset(new DwgMultiThreadedMode(m_pDb.get()));
+    m_exportAbort = std::make_shared<std::atomic<bool>>(false);
+
+    OdDbDatabasePtr pDb = m_pDb;
+    std::shared_ptr<std::atomic<bool>> abort = m_exportAbort;
+    const int document = DwgMemory::documentFor(m_pDb.get());
+    QPointer<MainWindow> self(this);
+    m_exportThread = QThread::create([=]() {
+        DwgThreadScope threadScope;
+        DwgMemory::DocumentScope memoryScope(document);
+        auto progress = [self](int percent) {
+            QMetaObject::invokeMethod(self, [self, percent]() {
+                if (self)
+                    self->statusBar()->showMessage(QString("Export de l'image : %1 %").arg(percent));
+            }, Qt::QueuedConnection);
+        };
+        const DwgStripExportResult result = DwgStripExport::exportTiff(pDb, filePath, settings, progress, abort.get());
+        QMetaObject::invokeMethod(self, [self, result, filePath, settings]() {
+            if (!self)
+                return;
+            if (result.ok)
+                self->statusBar()->showMessage(QString("Image exportée : %1 (%2 x %3, %4 Mo, %5 s)")
+                                                   .arg(filePath).arg(settings.size.width()).arg(settings.size.height())
+                                                   .arg(result.bytes / (1024 * 1024)).arg(result.totalMs / 1000.0, 0, 'f', 1),
+                                               10000);
+            else
+                self->statusBar()->showMessage("Export de l'image interrompu : " + result.error, 5000);
+        }, Qt::QueuedConnection);
+    });
+    m_exportThread->setObjectName("DwgStripExport");
+    QThread* thread = m_exportThread;
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        if (m_exportThread != thread)
+            return;
+        m_exportThread->deleteLater();
+        m_exportThread = nullptr;
+        m_exportAbort.reset();
+        m_exportMultiThreaded.reset();
+    });
+    statusBar()->showMessage(QString("Export de l'image : %1 x %2 pixels").arg(settings.size.width()).arg(settings.size.height()));
+    m_exportThread->start();
+}
+
+void MainWindow::stopImageExport()
+{
+    // L'export lit la base : arrêté avant toute modification ou fermeture
+    if (!m_exportThread)
+        return;
+    *m_exportAbort = true;
+    m_exportThread->wait();
+    delete m_exportThread;
+    m_exportThread = nullptr;
+    m_exportAbort.reset();
+    m_exportMultiThreaded.reset();
+}
+
+void MainWindow::startTextIndex()
+{
+    stopTextIndex();
+    m_textIndex.reset();
+    m_findResults->clear();
+    m_findEdit->setEnabled(false);
+    m_findStatus->setText(m_pDb.isNull() ? QString() : QString("Indexation des textes..."));
+    delete m_findMarker;
+    m_findMarker = nullptr;
+    if (m_pDb.isNull())
+        return;
+
+    // Lu en même temps que les threads de tuiles et de vignettes
+    m_textIndexMultiThreaded.reset(new DwgMultiThreadedMode(m_pDb.get()));
+    m_textIndexAbort = std::make_shared<std::atomic<bool>>(false);
+
+    OdDbDatabasePtr pDb = m_pDb;
+    std::shared_ptr<std::atomic<bool>> abort = m_textIndexAbort;
+    const int document = DwgMemory::documentFor(m_pDb.get());
+    QPointer<MainWindow> self(this);
+    m_textIndexThread = QThread::create([=]() {
+        DwgThreadScope threadScope;
+        DwgMemory::DocumentScope memoryScope(document);
+        const DwgTextIndexPtr index = DwgTextIndex::build(pDb.get(), abort.get());
+        QMetaObject::invokeMethod(self, [self, abort, index]() {
+            if (!self || *abort || !index)
+                return;
+            self->m_textIndex = index;
+            self->m_findEdit->setEnabled(true);
+            self->m_findStatus->setText(QString("%1 textes indexés").arg(index->size()));
+            if (!self->m_findEdit->text().isEmpty())
+                self->onFindTextChanged(self->m_findEdit->text());
+        }, Qt::QueuedConnection);
+    });
+    m_textIndexThread->setObjectName("DwgTextIndex");
+    QThread* thread = m_textIndexThread;
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        if (m_textIndexThread != thread)
+            return;
+        m_textIndexThread->deleteLater();
+        m_textIndexThread = nullptr;
+        m_textIndexAbort.reset();
+        m_textIndexMultiThreaded.reset();
+    });
+    m_textIndexThread->start(QThread::LowPriority);
+}
+
+void MainWindow::stopTextIndex()
+{
+    // L'indexation lit la base : arrêtée avant toute modification ou fermeture
+    if (!m_textIndexThread)
+        return;
+    *m_textIndexAbort = true;
+    m_textIndexThread->wait();
+    delete m_textIndexThread;
+    m_textIndexThread = nullptr;
+    m_textIndexAbort.reset();
+    m_textIndexMultiThreaded.reset();
+}
+
+void MainWindow::onFindTextChanged(const QString& text)
+{
+    m_findResults->clear();
+    if (!m_textIndex || text.trimmed().isEmpty()) {
+        if (m_textIndex)
+            m_findStatus->setText(QString("%1 textes indexés").arg(m_textIndex->size()));
+        return;
+    }
+
+    // Liste bornée : au-delà, la requête est trop vague pour être parcourue
+    const int kMaxResults = 500;
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<int> hits = m_textIndex->find(text, kMaxResults);
+    const qint64 findUs = timer.nsecsElapsed() / 1000;
+
+    for (int hit : hits) {
+        QListWidgetItem* item = new QListWidgetItem(m_textIndex->text(hit), m_findResults);
+        item->setData(Qt::UserRole, hit);
+        item->setToolTip(QString("Calque %1 — handle %2")
+                             .arg(m_textIndex->layerName(hit), QString::number(m_textIndex->handle(hit), 16).toUpper()));
+    }
+    m_findStatus->setText(QString("%1%2 résultats en %3 ms")
+                              .arg(hits.size()).arg(hits.size() >= kMaxResults ? "+" : "")
+                              .arg(findUs / 1000.0, 0, 'f', 1));
+}
+
+void MainWindow::onFindResultActivated(QListWidgetItem* item)
+{
+    if (!item || !m_textIndex)
+        return;
+
+    const int hit = item->data(Qt::UserRole).toInt();
+    const QRectF rect = m_textIndex->rect(hit);
+
+    // Repère au-dessus du dessin, trait d'épaisseur constante à l'écran
+    if (!m_findMarker) {
+        QPen pen(QColor(255, 0, 0), 2.0);
+        pen.setCosmetic(true);
+        m_findMarker = m_scene->addRect(QRectF(), pen);
+        m_findMarker->setZValue(1.0);
+    }
+    m_findMarker->setRect(rect);
+
+    // Le texte occupe environ un cinquième de la vue, quelle que soit sa taille
+    const qreal margin = qMax(qMax(rect.width(), rect.height()) * 2.0, 1.0);
+    m_view->animateTo(rect.adjusted(-margin, -margin, margin, margin));
+}
+
+void MainWindow::onEntityHovered(const QString& description)
+{
+    if (!description.isEmpty())
+        statusBar()->showMessage(description);
+    else if (statusBar()->currentMessage() == m_hoverMessage)
+        statusBar()->clearMessage();
+    m_hoverMessage = description;
 }
 
 
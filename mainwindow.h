@@ -7,10 +7,35 @@
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QWheelEvent>
+#include <QElapsedTimer>
+#include <QPair>
+#include <QPointer>
+
+#include <atomic>
+#include <memory>
 
 // Includes Teigha
 #include "DbDatabase.h"
 
+#include "DwgSpatialIndex.h"
+#include "DwgTextIndex.h"
+
+class DwgGraphicsView;
+class DwgLayoutBrowser;
+class DwgLiveReload;
+class QLabel;
+class QListWidget;
+class QListWidgetItem;
+class QProgressBar;
+class QPushButton;
+class DwgLoader;
+class DwgMultiThreadedMode;
+class DwgRendererItem;
+struct DwgTileSnapshot;
+class QGraphicsRectItem;
+class QLineEdit;
+class QThread;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -21,6 +46,24 @@ public:
 
 private slots:
     void openDwgFile();
+    void onLoadProgress(const QString& stage, int percent);
+    void onPreviewReady(const QString& filePath, const QImage& image);
+    void onDwgLoaded(const QString& filePath, OdDbDatabasePtr pDb);
+    void onLoadFailed(const QString& filePath, const QString& title, const QString& message);
+    void onLoadCancelled(const QString& filePath);
+    void onFirstFramePainted();
+    void onEntityHovered(const QString& description);
+    void exportTrace();
+    void exportImage();
+    void reportFrameStats();
+    void showMemoryStats();
+    void onLayerItemChanged(QListWidgetItem* item);
+    void onLayoutActivated(const QString& handle, const QString& name);
+    void onFileModified(const QString& filePath);
+    void onFindTextChanged(const QString& text);
+    void onFindResultActivated(QListWidgetItem* item);
+    void onDocumentReloaded(const QString& filePath, OdDbDatabasePtr pDb, const DwgSpatialIndexPtr& index,
+                            const QVector<QRectF>& changedRegions, bool allChanged);
 
 protected:
     void wheelEvent(QWheelEvent* event) override;
@@ -28,9 +71,64 @@ protected:
 
 private:
     void setupUi();
+    void closeDocument();
+    void stopImageExport();
+    void startTextIndex();
+    void stopTextIndex();
+    void showLoadProgress(bool visible);
+    void populateLayers();
+    DwgRendererItem* createRendererItem(const QImage& preview);
 
     QGraphicsScene* m_scene;
-    QGraphicsView* m_view;
+    DwgGraphicsView* m_view;
+    QLabel* m_frameStatsLabel;
+
+    // Lecture en arrière-plan
+    DwgLoader* m_loader;
+    // Rechargement du fichier ouvert quand il est enregistré ailleurs
+    DwgLiveReload* m_liveReload;
+    QProgressBar* m_progressBar;
+    QPushButton* m_cancelButton;
+
+    // Calques du document courant, cochés = visibles
+    QListWidget* m_layerList;
+    // Présentations du document courant, avec vignettes
+    DwgLayoutBrowser* m_layoutBrowser;
+
+    // Mesure du temps d'ouverture (lecture, puis première image)
+    QElapsedTimer m_openTimer;
+    qint64 m_loadMs = 0;
+    qint64 m_previewMs = -1;
+
+    // Aperçu du fichier en cours de lecture, affiché avant la base
+    QImage m_preview;
+    QGraphicsPixmapItem* m_previewItem = nullptr;
+    QString m_hoverMessage;
+
+    // Item du document courant (détruit avec la scène)
+    QPointer<DwgRendererItem> m_dwgItem;
+
+    // Tuiles des dernières présentations quittées, par handle (la plus
+    // récente en tête) : reprises au retour, même sans cache disque
+    QList<QPair<QString, std::shared_ptr<const DwgTileSnapshot>>> m_layoutTiles;
+    bool m_vectorMode = false;
+    bool m_scrollingMode = false;
+
+    // Recherche de texte : index construit en arrière-plan après chaque
+    // chargement (présentation active), repère sur le texte choisi
+    QLineEdit* m_findEdit;
+    QListWidget* m_findResults;
+    QLabel* m_findStatus;
+    QGraphicsRectItem* m_findMarker = nullptr;
+    DwgTextIndexPtr m_textIndex;
+    QThread* m_textIndexThread = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_textIndexAbort;
+    std::unique_ptr<DwgMultiThreadedMode> m_textIndexMultiThreaded;
+
+    // Export d'image grand format en cours (lit la base en parallèle du rendu)
+    QThread* m_exportThread = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_exportAbort;
+    std::unique_ptr<DwgMultiThreadedMode> m_exportMultiThreaded;
 
     // Pointeur intelligent vers la base de données DWG actuellement chargée
     OdDbDatabasePtr m_pDb;